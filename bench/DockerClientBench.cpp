@@ -0,0 +1,168 @@
+#include "DockerClient.hpp"
+#include "FakeDaemon.hpp"
+
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+using namespace DockerClientpp;
+using namespace DockerClientpp::Bench;
+
+//  Allocations of every thread but the mock daemon's are counted, so
+//  allocs/op also covers the worker threads of the client
+namespace {
+std::atomic<size_t> allocation_count(0);
+}  // namespace
+
+__attribute__((noinline)) void *operator new(size_t size) {
+  if (!FakeDaemon::onDaemonThread()) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void *p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+FakeDaemon &daemon() {
+  static FakeDaemon instance("/tmp/dockerclientpp-bench-" +
+                             std::to_string(getpid()) + ".sock");
+  return instance;
+}
+
+/**
+ * @brief Run fn once per iteration and report throughput, latency
+ *        percentiles and allocations
+ * @param items number of requests made by one call of fn
+ */
+template <typename Function>
+void measure(benchmark::State &state, size_t items, Function fn) {
+  typedef std::chrono::steady_clock Clock;
+  vector<double> latencies;
+  latencies.reserve(state.max_iterations);
+  size_t allocations = 0;
+  for (auto _ : state) {
+    size_t before = allocation_count.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    fn();
+    auto end = Clock::now();
+    allocations += allocation_count.load(std::memory_order_relaxed) - before;
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  state.SetItemsProcessed(state.iterations() * items);
+  if (latencies.empty()) return;
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&latencies](double p) {
+    return latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+  };
+  state.counters["p50_us"] = percentile(0.50);
+  state.counters["p90_us"] = percentile(0.90);
+  state.counters["p99_us"] = percentile(0.99);
+  state.counters["allocs/op"] =
+      static_cast<double>(allocations) / latencies.size();
+}
+}  // namespace
+
+//  Content-Length bodies
+
+static void BM_ListImages(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] { benchmark::DoNotOptimize(client.listImages()); });
+}
+BENCHMARK(BM_ListImages);
+
+static void BM_GetRunningContainers(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1,
+          [&] { benchmark::DoNotOptimize(client.getRunningContainers()); });
+}
+BENCHMARK(BM_GetRunningContainers);
+
+static void BM_InspectContainer(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] {
+    benchmark::DoNotOptimize(client.inspectContainer("container0", true));
+  });
+}
+BENCHMARK(BM_InspectContainer);
+
+static void BM_InspectContainerInfo(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] {
+    benchmark::DoNotOptimize(client.inspectContainerInfo("container0"));
+  });
+}
+BENCHMARK(BM_InspectContainerInfo);
+
+static void BM_GetContainerStatsSample(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] {
+    benchmark::DoNotOptimize(client.getContainerStatsSample("container0"));
+  });
+}
+BENCHMARK(BM_GetContainerStatsSample);
+
+static void BM_InspectContainers(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  vector<string> ids(state.range(0), "container0");
+  measure(state, ids.size(), [&] {
+    benchmark::DoNotOptimize(client.inspectContainers(ids));
+  });
+}
+BENCHMARK(BM_InspectContainers)->Arg(100);
+
+//  Bodiless responses
+
+static void BM_StartStopContainer(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 2, [&] {
+    client.stopContainer("container1");
+    client.startContainer("container1");
+  });
+}
+BENCHMARK(BM_StartStopContainer);
+
+//  Chunked bodies
+
+static void BM_WaitContainer(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] {
+    benchmark::DoNotOptimize(client.waitContainer("container0"));
+  });
+}
+BENCHMARK(BM_WaitContainer);
+
+static void BM_GetLogs(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  measure(state, 1, [&] {
+    benchmark::DoNotOptimize(client.getLogs("container0"));
+  });
+}
+BENCHMARK(BM_GetLogs);
+
+//  Raw stream until close, plus create and inspect of the execution
+
+static void BM_ExecuteCommand(benchmark::State &state) {
+  DockerClient client(SOCK_UNIX, daemon().path());
+  vector<string> cmd{"echo", "hello"};
+  measure(state, 3, [&] {
+    benchmark::DoNotOptimize(client.executeCommand("container0", cmd));
+  });
+}
+BENCHMARK(BM_ExecuteCommand);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,767 @@
+#include "FakeDaemon.hpp"
+#include "Exceptions.hpp"
+#include "ResponseParser.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+using namespace DockerClientpp;
+using namespace DockerClientpp::Bench;
+
+namespace {
+const size_t RECV_SIZE = 16 * 1024;
+const size_t CHUNK_SIZE = 16 * 1024;
+const size_t TAR_BLOCK_SIZE = 512;
+
+thread_local bool daemon_thread = false;
+
+string hexId(size_t seed) {
+  static const char hex[] = "0123456789abcdef";
+  string id(64, '0');
+  for (size_t i = 0; i < id.size(); ++i) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    id[i] = hex[(seed >> 60) & 0xf];
+  }
+  return id;
+}
+
+/**
+ * @brief Printable text of exactly size bytes ending with a newline
+ */
+string text(size_t size, size_t seed) {
+  string result = "line " + std::to_string(seed) + " ";
+  result.reserve(size);
+  while (result.size() < size) {
+    result.push_back('a' + result.size() % 26);
+  }
+  result.resize(size);
+  if (size != 0) result.back() = '\n';
+  return result;
+}
+
+string frame(STREAM_TYPE type, const string &payload) {
+  string result(8, '\0');
+  result[0] = static_cast<char>(type);
+  uint32_t size = payload.size();
+  result[4] = static_cast<char>(size >> 24);
+  result[5] = static_cast<char>(size >> 16);
+  result[6] = static_cast<char>(size >> 8);
+  result[7] = static_cast<char>(size);
+  return result + payload;
+}
+
+/**
+ * @brief Ustar archive holding a single regular file
+ */
+string tar(const string &name, const string &content) {
+  string header(TAR_BLOCK_SIZE, '\0');
+  strncpy(&header[0], name.c_str(), 99);
+  strcpy(&header[100], "0000644");
+  strcpy(&header[108], "0000000");
+  strcpy(&header[116], "0000000");
+  snprintf(&header[124], 12, "%011zo", content.size());
+  strcpy(&header[136], "13000000000");
+  header[156] = '0';
+  memcpy(&header[257], "ustar", 6);
+  memcpy(&header[263], "00", 2);
+  //  The checksum is computed with its own field filled with spaces
+  memset(&header[148], ' ', 8);
+  unsigned checksum = 0;
+  for (char c : header) checksum += static_cast<unsigned char>(c);
+  snprintf(&header[148], 8, "%06o", checksum);
+  size_t padding = (TAR_BLOCK_SIZE - content.size() % TAR_BLOCK_SIZE) %
+                   TAR_BLOCK_SIZE;
+  return header + content + string(padding + 2 * TAR_BLOCK_SIZE, '\0');
+}
+
+bool sendAll(int fd, const string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n =
+        ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    sent += n;
+  }
+  return true;
+}
+
+string fixedResponse(int status_code, const string &reason,
+                     const string &body) {
+  string head = "HTTP/1.1 " + std::to_string(status_code) + " " + reason +
+                "\r\nContent-Type: application/json\r\n";
+  head += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+  return head + body;
+}
+
+string errorResponse(int status_code, const string &reason,
+                     const string &message) {
+  return fixedResponse(status_code, reason, json{{"message", message}}.dump());
+}
+
+string emptyResponse(int status_code, const string &reason) {
+  return "HTTP/1.1 " + std::to_string(status_code) + " " + reason +
+         "\r\n\r\n";
+}
+
+string chunkedHead(const string &content_type) {
+  return "HTTP/1.1 200 OK\r\nContent-Type: " + content_type +
+         "\r\nTransfer-Encoding: chunked\r\n\r\n";
+}
+
+string chunks(const string &body) {
+  string result;
+  char size_line[32];
+  for (size_t pos = 0; pos < body.size(); pos += CHUNK_SIZE) {
+    size_t size = std::min(CHUNK_SIZE, body.size() - pos);
+    snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+    result += size_line;
+    result.append(body, pos, size);
+    result += "\r\n";
+  }
+  return result;
+}
+
+string chunkedResponse(const string &content_type, const string &body) {
+  return chunkedHead(content_type) + chunks(body) + "0\r\n\r\n";
+}
+
+bool startsWith(const string &value, const char *prefix) {
+  return value.compare(0, strlen(prefix), prefix) == 0;
+}
+
+bool isTrue(const Http::QueryParam &query, const char *key) {
+  auto it = query.find(key);
+  return it != query.end() && (it->second == "1" || it->second == "true");
+}
+
+json imagesList(size_t count) {
+  json images = json::array();
+  for (size_t i = 0; i < count; ++i) {
+    string name = "image" + std::to_string(i);
+    images.push_back({{"Id", "sha256:" + hexId(i)},
+                      {"ParentId", ""},
+                      {"RepoTags", {name + ":1." + std::to_string(i),
+                                    name + ":latest"}},
+                      {"RepoDigests", {name + "@sha256:" + hexId(i + 1000)}},
+                      {"Created", 1500000000 + i},
+                      {"Size", 4000000 + i},
+                      {"SharedSize", -1},
+                      {"VirtualSize", 4000000 + i},
+                      {"Labels", {{"maintainer", "bench"}}},
+                      {"Containers", -1}});
+  }
+  return images;
+}
+
+json statsSample() {
+  json cpu = {{"cpu_usage",
+               {{"total_usage", 123456789},
+                {"percpu_usage", {30000000, 31000000, 32000000, 30456789}},
+                {"usage_in_kernelmode", 10000000},
+                {"usage_in_usermode", 100000000}}},
+              {"system_cpu_usage", 987654321000},
+              {"online_cpus", 4},
+              {"throttling_data",
+               {{"periods", 0}, {"throttled_periods", 0},
+                {"throttled_time", 0}}}};
+  return {{"read", "2017-01-01T00:00:02.000000000Z"},
+          {"preread", "2017-01-01T00:00:01.000000000Z"},
+          {"pids_stats", {{"current", 3}}},
+          {"networks",
+           {{"eth0",
+             {{"rx_bytes", 5219}, {"rx_packets", 60}, {"rx_errors", 0},
+              {"tx_bytes", 648}, {"tx_packets", 8}, {"tx_errors", 0}}}}},
+          {"memory_stats",
+           {{"usage", 1609728},
+            {"max_usage", 2265088},
+            {"limit", 8363986944},
+            {"stats", {{"cache", 0}, {"rss", 286720}, {"mapped_file", 0}}}}},
+          {"blkio_stats", {{"io_service_bytes_recursive", json::array()}}},
+          {"cpu_stats", cpu},
+          {"precpu_stats", cpu}};
+}
+
+json bridgeNetwork(size_t seed) {
+  return {{"NetworkID", hexId(3)},
+          {"EndpointID", hexId(seed + 4)},
+          {"Gateway", "172.17.0.1"},
+          {"IPAddress", "172.17.0." + std::to_string(seed % 250 + 2)},
+          {"IPPrefixLen", 16},
+          {"MacAddress", "02:42:ac:11:00:02"}};
+}
+}  // namespace
+
+FakeDaemon::FakeDaemon(const string &path, const FakeDaemonOptions &options)
+    : socket_path(path),
+      options(options),
+      listen_fd(-1),
+      stopping(false),
+      accepted(0),
+      answered(0),
+      next_id(0),
+      lists_valid(false) {
+  images_body = imagesList(options.images).dump();
+  stats_body = statsSample().dump();
+  for (size_t i = 0; i < options.log_lines; ++i) {
+    STREAM_TYPE type = i % 10 == 0 ? STREAM_STDERR : STREAM_STDOUT;
+    logs_body += frame(type, text(options.log_line_size, i));
+  }
+  size_t half = options.exec_output_size / 2;
+  exec_output = frame(STREAM_STDOUT, text(options.exec_output_size - half, 0));
+  if (half != 0) exec_output += frame(STREAM_STDERR, text(half, 1));
+  archive_body = text(options.archive_size, 0);
+  for (size_t i = 0; i < options.containers; ++i) {
+    string id = createContainer("container" + std::to_string(i), "busybox");
+    setRunning(containers[id], true, 0);
+  }
+
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw SocketError("Socket path too long: " + path);
+  }
+  strcpy(addr.sun_path, path.c_str());
+  ::unlink(path.c_str());
+  if ((listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+      ::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      ::listen(listen_fd, 1024) < 0) {
+    string what = strerror(errno);
+    if (listen_fd >= 0) ::close(listen_fd);
+    throw SocketError(what);
+  }
+  acceptor = std::thread([this] { acceptLoop(); });
+}
+
+FakeDaemon::~FakeDaemon() {
+  stopping = true;
+  //  Wakes the blocked accept() and every worker blocked in recv()
+  ::shutdown(listen_fd, SHUT_RDWR);
+  acceptor.join();
+  {
+    std::lock_guard<std::mutex> lock(connection_mutex);
+    for (int fd : connection_fds) {
+      if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+    }
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  ::close(listen_fd);
+  ::unlink(socket_path.c_str());
+}
+
+bool FakeDaemon::onDaemonThread() {
+  return daemon_thread;
+}
+
+void FakeDaemon::acceptLoop() {
+  daemon_thread = true;
+  while (!stopping) {
+    int fd = ::accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      return;
+    }
+    accepted++;
+    std::lock_guard<std::mutex> lock(connection_mutex);
+    if (stopping) {
+      ::close(fd);
+      return;
+    }
+    connection_fds.push_back(fd);
+    workers.emplace_back([this, fd] { serve(fd); });
+  }
+}
+
+void FakeDaemon::serve(int fd) {
+  daemon_thread = true;
+  string input;
+  char buffer[RECV_SIZE];
+  size_t body_begin = string::npos;
+  Http::Request request;
+  size_t content_length = 0;
+  bool chunked = false;
+  bool open = true;
+  while (open) {
+    ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    input.append(buffer, n);
+    try {
+      while (open) {
+        if (body_begin == string::npos) {
+          size_t head_end = input.find("\r\n\r\n");
+          if (head_end == string::npos) break;
+          size_t line_end = input.find("\r\n");
+          size_t first_space = input.find(' ');
+          size_t second_space = input.find(' ', first_space + 1);
+          if (second_space > line_end) {
+            throw ParseError("Invalid request line");
+          }
+          request = Http::Request();
+          request.method = input.substr(0, first_space);
+          string target =
+              input.substr(first_space + 1, second_space - first_space - 1);
+          size_t question = target.find('?');
+          request.uri = target.substr(0, question);
+          while (question != string::npos) {
+            size_t begin = question + 1;
+            question = target.find('&', begin);
+            string pair = target.substr(begin, question - begin);
+            size_t equal = pair.find('=');
+            request.query_param[pair.substr(0, equal)] =
+                equal == string::npos ? "" : pair.substr(equal + 1);
+          }
+          for (size_t pos = line_end + 2; pos < head_end;) {
+            size_t end = input.find("\r\n", pos);
+            request.header.parseLine(input.data() + pos, input.data() + end);
+            pos = end + 2;
+          }
+          auto length_it = request.header.find("Content-Length");
+          auto encoding_it = request.header.find("Transfer-Encoding");
+          content_length = length_it == request.header.end()
+                               ? 0
+                               : std::stoul(length_it->second);
+          chunked = encoding_it != request.header.end() &&
+                    encoding_it->second == "chunked";
+          body_begin = head_end + 4;
+        }
+        size_t request_end = string::npos;
+        if (chunked) {
+          //  Decoded again from the start each time more data arrives,
+          //  uploads are rare and small next to the responses
+          request.body.clear();
+          size_t pos = body_begin;
+          while (true) {
+            size_t line = Http::ResponseParser::lineSize(input.data() + pos,
+                                                         input.size() - pos);
+            if (line == 0) break;
+            size_t size = Http::ResponseParser::parseChunkSize(
+                StringRef(input.data() + pos, line - 2));
+            if (size == 0) {
+              if (input.size() - pos >= line + 2) request_end = pos + line + 2;
+              break;
+            }
+            if (input.size() - pos < line + size + 2) break;
+            request.body.append(input, pos + line, size);
+            pos += line + size + 2;
+          }
+          if (request_end == string::npos) break;
+        } else {
+          if (input.size() - body_begin < content_length) break;
+          request_end = body_begin + content_length;
+          request.body.assign(input, body_begin, content_length);
+        }
+        input.erase(0, request_end);
+        body_begin = string::npos;
+        open = respond(fd, request);
+      }
+    } catch (std::exception &) {
+      //  Malformed request, the real daemon drops the connection as well
+      break;
+    }
+  }
+  std::lock_guard<std::mutex> lock(connection_mutex);
+  ::close(fd);
+  for (auto &connection_fd : connection_fds) {
+    if (connection_fd == fd) connection_fd = -1;
+  }
+}
+
+bool FakeDaemon::respond(int fd, const Http::Request &request) {
+  size_t index = ++answered;
+  if (options.latency.count() > 0) {
+    std::this_thread::sleep_for(options.latency);
+  }
+  if (options.fail_every != 0 && index % options.fail_every == 0) {
+    return sendAll(fd, errorResponse(500, "Internal Server Error",
+                                     "injected failure"));
+  }
+
+  string path = request.uri;
+  //  Versioned paths are served like unversioned ones
+  if (startsWith(path, "/v") && path.find('/', 1) != string::npos) {
+    path.erase(0, path.find('/', 1));
+  }
+
+  if (path == "/_ping") {
+    return sendAll(fd,
+                   "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                   "Content-Length: 2\r\n\r\nOK");
+  }
+  if (path == "/images/json" && request.method == "GET") {
+    return sendAll(fd, fixedResponse(200, "OK", images_body));
+  }
+  if (path == "/containers/json" && request.method == "GET") {
+    std::unique_lock<std::mutex> lock(state_mutex);
+    string response = fixedResponse(
+        200, "OK", containerList(isTrue(request.query_param, "all")));
+    lock.unlock();
+    return sendAll(fd, response);
+  }
+  if (path == "/containers/create" && request.method == "POST") {
+    string image;
+    try {
+      json config = json::parse(request.body);
+      auto image_it = config.find("Image");
+      if (image_it != config.end() && image_it->is_string()) {
+        image = image_it->get<string>();
+      }
+    } catch (std::exception &) {
+      return sendAll(fd, errorResponse(400, "Bad Request",
+                                       "invalid container config"));
+    }
+    auto name_it = request.query_param.find("name");
+    string name = name_it == request.query_param.end() ? "" : name_it->second;
+    string id;
+    {
+      std::lock_guard<std::mutex> lock(state_mutex);
+      if (name.empty() || container_ids.count(name) == 0) {
+        id = createContainer(name, image);
+      }
+    }
+    if (id.empty()) {
+      return sendAll(fd, errorResponse(409, "Conflict",
+                                       "Conflict. The container name \"/" +
+                                           name + "\" is already in use"));
+    }
+    return sendAll(fd, fixedResponse(201, "Created",
+                                     json{{"Id", id},
+                                          {"Warnings", json::array()}}
+                                         .dump()));
+  }
+  if (startsWith(path, "/containers/")) {
+    size_t begin = strlen("/containers/");
+    size_t slash = path.find('/', begin);
+    string identifier = path.substr(begin, slash - begin);
+    string action = slash == string::npos ? "" : path.substr(slash + 1);
+    return respondContainer(fd, request, identifier, action);
+  }
+  if (startsWith(path, "/exec/")) {
+    size_t begin = strlen("/exec/");
+    size_t slash = path.find('/', begin);
+    string id = path.substr(begin, slash - begin);
+    string action = slash == string::npos ? "" : path.substr(slash + 1);
+    return respondExecution(fd, request, id, action);
+  }
+  return sendAll(fd, errorResponse(404, "Not Found", "page not found"));
+}
+
+bool FakeDaemon::respondContainer(int fd, const Http::Request &request,
+                                  const string &identifier,
+                                  const string &action) {
+  const string &method = request.method;
+  std::unique_lock<std::mutex> lock(state_mutex);
+  //  The response is built under the lock and sent without it
+  auto reply = [&lock, fd](const string &response) {
+    lock.unlock();
+    return sendAll(fd, response);
+  };
+  Container *container = findContainer(identifier);
+  if (container == nullptr) {
+    return reply(errorResponse(404, "Not Found",
+                               "No such container: " + identifier));
+  }
+
+  if (method == "GET" && action == "json") {
+    return reply(fixedResponse(200, "OK", inspectBody(*container)));
+  }
+  if (method == "DELETE" && action.empty()) {
+    if (container->running && !isTrue(request.query_param, "force")) {
+      return reply(errorResponse(409, "Conflict",
+                                 "You cannot remove a running container " +
+                                     container->id +
+                                     ". Stop the container before attempting "
+                                     "removal or force remove"));
+    }
+    container_ids.erase(container->name);
+    containers.erase(container->id);
+    lists_valid = false;
+    return reply(emptyResponse(204, "No Content"));
+  }
+  if (method == "POST" && (action == "start" || action == "stop")) {
+    bool start = action == "start";
+    if (container->running == start) {
+      return reply(emptyResponse(304, "Not Modified"));
+    }
+    setRunning(*container, start, 0);
+    return reply(emptyResponse(204, "No Content"));
+  }
+  if (method == "POST" && action == "restart") {
+    setRunning(*container, true, 0);
+    return reply(emptyResponse(204, "No Content"));
+  }
+  if (method == "POST" && action == "kill") {
+    if (!container->running) {
+      return reply(errorResponse(
+          409, "Conflict", "Container " + container->id + " is not running"));
+    }
+    setRunning(*container, false, 137);
+    return reply(emptyResponse(204, "No Content"));
+  }
+  if (method == "POST" && action == "wait") {
+    //  Answers at once, a container never stops by itself here
+    return reply(chunkedResponse(
+        "application/json",
+        json{{"StatusCode", container->exit_code}}.dump()));
+  }
+  if (method == "POST" && action == "update") {
+    return reply(fixedResponse(200, "OK", R"({"Warnings":[]})"));
+  }
+  if (method == "POST" && action == "exec") {
+    if (!container->running) {
+      return reply(errorResponse(
+          409, "Conflict", "Container " + container->id + " is not running"));
+    }
+    Execution execution;
+    execution.id = hexId(next_id++);
+    execution.container_id = container->id;
+    executions[execution.id] = execution;
+    return reply(
+        fixedResponse(201, "Created", json{{"Id", execution.id}}.dump()));
+  }
+  lock.unlock();
+
+  if (method == "GET" && action == "logs") {
+    //  Stream selection, tail and timestamps are not emulated
+    return sendAll(fd,
+                   chunkedResponse("application/vnd.docker.multiplexed-stream",
+                                   logs_body));
+  }
+  if (method == "GET" && action == "stats") {
+    auto stream_it = request.query_param.find("stream");
+    if (stream_it != request.query_param.end() &&
+        (stream_it->second == "0" || stream_it->second == "false")) {
+      return sendAll(fd, fixedResponse(200, "OK", stats_body));
+    }
+    if (!sendAll(fd, chunkedHead("application/json"))) return false;
+    for (size_t i = 0; i < options.stats_samples && !stopping; ++i) {
+      if (i != 0 && options.stats_interval.count() > 0) {
+        std::this_thread::sleep_for(options.stats_interval);
+      }
+      if (!sendAll(fd, chunks(stats_body + "\n"))) return false;
+    }
+    return sendAll(fd, "0\r\n\r\n");
+  }
+  if (method == "PUT" && action == "archive") {
+    return sendAll(fd, fixedResponse(200, "OK", ""));
+  }
+  if (method == "GET" && action == "archive") {
+    auto path_it = request.query_param.find("path");
+    string name = path_it == request.query_param.end() ? "" : path_it->second;
+    name = name.substr(name.rfind('/') + 1);
+    if (name.empty()) name = "file";
+    return sendAll(fd, chunkedResponse("application/x-tar",
+                                       tar(name, archive_body)));
+  }
+  return sendAll(fd, errorResponse(404, "Not Found", "page not found"));
+}
+
+bool FakeDaemon::respondExecution(int fd, const Http::Request &request,
+                                  const string &id, const string &action) {
+  std::unique_lock<std::mutex> lock(state_mutex);
+  auto reply = [&lock, fd](const string &response) {
+    lock.unlock();
+    return sendAll(fd, response);
+  };
+  auto it = executions.find(id);
+  if (it == executions.end()) {
+    return reply(errorResponse(404, "Not Found",
+                               "No such exec instance: " + id));
+  }
+  Execution &execution = it->second;
+
+  if (request.method == "GET" && action == "json") {
+    string body = json{{"ID", execution.id},
+                       {"Running", execution.running},
+                       {"ExitCode", execution.exit_code},
+                       {"ProcessConfig",
+                        {{"tty", false},
+                         {"entrypoint", "sh"},
+                         {"arguments", json::array()},
+                         {"privileged", false}}},
+                       {"OpenStdin", false},
+                       {"OpenStderr", true},
+                       {"OpenStdout", true},
+                       {"ContainerID", execution.container_id},
+                       {"Pid", 0}}
+                      .dump();
+    return reply(fixedResponse(200, "OK", body));
+  }
+  if (request.method == "POST" && action == "start") {
+    //  The command has finished by the time its output is sent
+    execution.exit_code = 0;
+    lock.unlock();
+    bool detach = false;
+    try {
+      json config = json::parse(request.body);
+      auto detach_it = config.find("Detach");
+      detach = detach_it != config.end() && detach_it->is_boolean() &&
+               detach_it->get<bool>();
+    } catch (std::exception &) {
+    }
+    if (detach) {
+      return sendAll(fd, fixedResponse(200, "OK", ""));
+    }
+    //  Hijacked connection: frames until the daemon closes it
+    sendAll(fd,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/vnd.docker.raw-stream\r\n\r\n" +
+                exec_output);
+    return false;
+  }
+  if (request.method == "POST" && action == "resize") {
+    return reply(emptyResponse(201, "Created"));
+  }
+  return reply(errorResponse(404, "Not Found", "page not found"));
+}
+
+string FakeDaemon::createContainer(const string &name, const string &image) {
+  Container container;
+  container.id = hexId(next_id++);
+  container.name =
+      name.empty() ? "fake_" + container.id.substr(0, 12) : name;
+  container.image = image.empty() ? "busybox" : image;
+  container_ids[container.name] = container.id;
+  string id = container.id;
+  Container &stored = containers[id] = container;
+  setRunning(stored, false, 0);
+  return id;
+}
+
+FakeDaemon::Container *FakeDaemon::findContainer(const string &identifier) {
+  string key = startsWith(identifier, "/") ? identifier.substr(1) : identifier;
+  if (key.empty()) return nullptr;
+  auto name_it = container_ids.find(key);
+  if (name_it != container_ids.end()) {
+    return &containers[name_it->second];
+  }
+  //  Full id or an unambiguous prefix of one
+  auto it = containers.lower_bound(key);
+  if (it == containers.end() || it->first.compare(0, key.size(), key) != 0) {
+    return nullptr;
+  }
+  auto next = std::next(it);
+  if (next != containers.end() &&
+      next->first.compare(0, key.size(), key) == 0) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void FakeDaemon::setRunning(Container &container, bool running,
+                            int exit_code) {
+  container.running = running;
+  container.exit_code = running ? 0 : exit_code;
+  container.pid = running ? 1000 + static_cast<int>(next_id++ % 30000) : 0;
+  container.inspect_valid = false;
+  lists_valid = false;
+}
+
+const string &FakeDaemon::inspectBody(Container &container) {
+  if (container.inspect_valid) return container.inspect_body;
+  bool running = container.running;
+
+  json env = json::array();
+  for (size_t i = 0; i < 20; ++i) {
+    env.push_back("VARIABLE_" + std::to_string(i) + "=" + hexId(i));
+  }
+  json state = {{"Status", running ? "running" : "exited"},
+                {"Running", running},
+                {"Paused", false},
+                {"Restarting", false},
+                {"OOMKilled", false},
+                {"Dead", false},
+                {"Pid", container.pid},
+                {"ExitCode", container.exit_code},
+                {"Error", ""},
+                {"StartedAt", "2017-01-01T00:00:01.000000000Z"},
+                {"FinishedAt", "0001-01-01T00:00:00Z"}};
+  string directory = "/var/lib/docker/containers/" + container.id;
+  container.inspect_body =
+      json{{"Id", container.id},
+           {"Created", "2017-01-01T00:00:00.000000000Z"},
+           {"Path", "sh"},
+           {"Args", json::array()},
+           {"State", state},
+           {"Image", "sha256:" + hexId(1)},
+           {"ResolvConfPath", directory + "/resolv.conf"},
+           {"HostnamePath", directory + "/hostname"},
+           {"HostsPath", directory + "/hosts"},
+           {"LogPath", directory + "/" + container.id + "-json.log"},
+           {"Name", "/" + container.name},
+           {"RestartCount", 0},
+           {"Driver", "overlay2"},
+           {"MountLabel", ""},
+           {"ProcessLabel", ""},
+           {"AppArmorProfile", ""},
+           {"ExecIDs", json::array()},
+           {"HostConfig",
+            {{"Binds", json::array()},
+             {"NetworkMode", "default"},
+             {"RestartPolicy", {{"Name", "no"}, {"MaximumRetryCount", 0}}},
+             {"Memory", 0},
+             {"CpuShares", 0}}},
+           {"Mounts", json::array()},
+           {"Config",
+            {{"Hostname", container.id.substr(0, 12)},
+             {"AttachStdout", true},
+             {"Tty", true},
+             {"Env", env},
+             {"Cmd", {"sh"}},
+             {"Image", container.image},
+             {"Labels", {{"com.example.bench", "true"}}},
+             {"StopSignal", "SIGKILL"}}},
+           {"NetworkSettings",
+            {{"Bridge", ""},
+             {"SandboxID", hexId(5)},
+             {"Ports", json::object()},
+             {"IPAddress", running ? "172.17.0.2" : ""},
+             {"Networks", {{"bridge", bridgeNetwork(container.pid)}}}}}}
+          .dump();
+  container.inspect_valid = true;
+  return container.inspect_body;
+}
+
+const string &FakeDaemon::containerList(bool all) {
+  if (!lists_valid) {
+    json running = json::array();
+    json every = json::array();
+    for (const auto &entry : containers) {
+      const Container &container = entry.second;
+      json item = {
+          {"Id", container.id},
+          {"Names", {"/" + container.name}},
+          {"Image", container.image},
+          {"ImageID", "sha256:" + hexId(1)},
+          {"Command", "sh"},
+          {"Created", 1500000000},
+          {"Ports", json::array()},
+          {"Labels", json::object()},
+          {"State", container.running ? "running" : "exited"},
+          {"Status", container.running
+                         ? "Up 2 hours"
+                         : "Exited (" + std::to_string(container.exit_code) +
+                               ") 1 hour ago"},
+          {"HostConfig", {{"NetworkMode", "default"}}},
+          {"NetworkSettings",
+           {{"Networks", {{"bridge", bridgeNetwork(container.pid)}}}}},
+          {"Mounts", json::array()}};
+      if (container.running) running.push_back(item);
+      every.push_back(std::move(item));
+    }
+    running_list = running.dump();
+    all_list = every.dump();
+    lists_valid = true;
+  }
+  return all ? all_list : running_list;
+}
@@ -0,0 +1,163 @@
+#ifndef DOCKER_CLIENT_PP_FAKEDAEMON_H
+#define DOCKER_CLIENT_PP_FAKEDAEMON_H
+
+#include "Request.hpp"
+#include "defines.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace DockerClientpp {
+namespace Bench {
+/**
+ * @brief Workload of a FakeDaemon
+ */
+struct FakeDaemonOptions {
+  size_t containers = 100;       ///<  Running containers named container<N>
+  size_t images = 100;           ///<  Entries of the image list
+  size_t log_lines = 1000;       ///<  Lines returned by logs
+  size_t log_line_size = 64;     ///<  Bytes of each log line
+  size_t exec_output_size = 64;  ///<  Bytes written by each execution
+  size_t archive_size = 4096;    ///<  Bytes of the file served by archive
+  size_t stats_samples = 10;     ///<  Samples sent by streamed stats
+  std::chrono::microseconds latency =
+      std::chrono::microseconds(0);  ///<  Delay before each response
+  std::chrono::milliseconds stats_interval =
+      std::chrono::milliseconds(0);  ///<  Delay between streamed samples
+  size_t fail_every = 0;  ///<  Answer every Nth request with 500, 0 for never
+};
+
+/**
+ * @brief Docker daemon stand-in serving the engine API over a Unix socket
+ *
+ * Keeps container and execution state in memory, so lifecycle calls behave
+ * like the real daemon: create, start, stop, kill, wait and remove change
+ * what inspect and the container list report, and unknown containers give
+ * 404. Names, full ids and id prefixes all identify a container. Bodies
+ * come in the three framings the client has to handle:
+ *   - Content-Length: lists, inspect, stats, create and exec inspect
+ *   - chunked: wait, logs, streamed stats and archive downloads
+ *   - raw stream until close: exec start
+ *
+ * Every response is identical between runs for the same requests, only
+ * the optional latency and failures are added on top. Every connection is
+ * served by its own thread and kept alive as long as the client wants.
+ */
+class FakeDaemon {
+  /**
+   * @brief Disallow copy
+   */
+  FakeDaemon(const FakeDaemon &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  FakeDaemon &operator=(const FakeDaemon &) = delete;
+
+ public:
+  /**
+   * @brief Start listening
+   * @param path path of the unix socket, an existing file is replaced
+   * @param options workload served
+   */
+  explicit FakeDaemon(const string &path,
+                      const FakeDaemonOptions &options = FakeDaemonOptions());
+
+  /**
+   * @brief Stop listening and close every connection
+   */
+  ~FakeDaemon();
+
+  const string &path() const {
+    return socket_path;
+  }
+
+  /**
+   * @brief Number of connections accepted so far
+   */
+  size_t connections() const {
+    return accepted;
+  }
+
+  /**
+   * @brief Number of requests answered so far
+   */
+  size_t requests() const {
+    return answered;
+  }
+
+  /**
+   * @brief Whether the calling thread is one of the daemon's own threads
+   *
+   * Lets allocation counters leave out the work of the daemon
+   */
+  static bool onDaemonThread();
+
+ private:
+  struct Container {
+    string id;
+    string name;
+    string image;
+    bool running = false;
+    int exit_code = 0;
+    int pid = 0;
+    string inspect_body;  //  Rebuilt by the first inspect after a change
+    bool inspect_valid = false;
+  };
+
+  struct Execution {
+    string id;
+    string container_id;
+    bool running = false;
+    int exit_code = 0;
+  };
+
+  void acceptLoop();
+  void serve(int fd);
+  bool respond(int fd, const Http::Request &request);
+  bool respondContainer(int fd, const Http::Request &request,
+                        const string &identifier, const string &action);
+  bool respondExecution(int fd, const Http::Request &request,
+                        const string &id, const string &action);
+
+  //  Callers hold state_mutex
+  string createContainer(const string &name, const string &image);
+  Container *findContainer(const string &identifier);
+  void setRunning(Container &container, bool running, int exit_code);
+  const string &inspectBody(Container &container);
+  const string &containerList(bool all);
+
+  string socket_path;
+  FakeDaemonOptions options;
+  int listen_fd;
+  std::atomic<bool> stopping;
+  std::atomic<size_t> accepted;
+  std::atomic<size_t> answered;
+  std::thread acceptor;
+
+  std::mutex connection_mutex;
+  vector<int> connection_fds;
+  vector<std::thread> workers;
+
+  std::mutex state_mutex;
+  std::map<string, Container> containers;  //  By id
+  std::map<string, string> container_ids;  //  Id by name
+  std::map<string, Execution> executions;  //  By id
+  size_t next_id;
+  bool lists_valid;
+  string running_list;
+  string all_list;
+
+  //  Bodies that do not depend on the state, built once
+  string images_body;
+  string stats_body;
+  string logs_body;
+  string exec_output;
+  string archive_body;
+};
+}  // namespace Bench
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_FAKEDAEMON_H */
@@ -0,0 +1,109 @@
+#include "FakeDaemon.hpp"
+
+#include <signal.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using namespace DockerClientpp;
+using namespace DockerClientpp::Bench;
+
+namespace {
+const char *USAGE =
+    "Usage: DockerClientppFakeDaemon [options]\n"
+    "Serve the docker engine API on a unix socket, without docker\n"
+    "\n"
+    "  --socket PATH            unix socket to listen on\n"
+    "                           (default /tmp/dockerclientpp-fake.sock)\n"
+    "  --containers N           running containers at start (100)\n"
+    "  --images N               entries of the image list (100)\n"
+    "  --log-lines N            lines returned by logs (1000)\n"
+    "  --log-line-size BYTES    size of each log line (64)\n"
+    "  --exec-output-size BYTES output of each execution (64)\n"
+    "  --archive-size BYTES     size of the file served by archive (4096)\n"
+    "  --stats-samples N        samples sent by streamed stats (10)\n"
+    "  --stats-interval-ms MS   delay between streamed samples (0)\n"
+    "  --latency-us US          delay before each response (0)\n"
+    "  --fail-every N           answer every Nth request with 500 (0, never)\n";
+
+bool parseSize(const char *value, size_t &result) {
+  char *end = nullptr;
+  errno = 0;
+  unsigned long long parsed = strtoull(value, &end, 10);
+  if (errno != 0 || end == value || *end != '\0' || value[0] == '-') {
+    return false;
+  }
+  result = parsed;
+  return true;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  string path = "/tmp/dockerclientpp-fake.sock";
+  FakeDaemonOptions options;
+  for (int i = 1; i < argc; ++i) {
+    string flag = argv[i];
+    if (flag == "-h" || flag == "--help") {
+      std::cout << USAGE;
+      return 0;
+    }
+    if (i + 1 == argc) {
+      std::cerr << "Missing value of " << flag << "\n" << USAGE;
+      return 2;
+    }
+    const char *value = argv[++i];
+    size_t number = 0;
+    bool valid = flag == "--socket" || parseSize(value, number);
+    if (flag == "--socket") {
+      path = value;
+    } else if (flag == "--containers") {
+      options.containers = number;
+    } else if (flag == "--images") {
+      options.images = number;
+    } else if (flag == "--log-lines") {
+      options.log_lines = number;
+    } else if (flag == "--log-line-size") {
+      options.log_line_size = number;
+    } else if (flag == "--exec-output-size") {
+      options.exec_output_size = number;
+    } else if (flag == "--archive-size") {
+      options.archive_size = number;
+    } else if (flag == "--stats-samples") {
+      options.stats_samples = number;
+    } else if (flag == "--stats-interval-ms") {
+      options.stats_interval = std::chrono::milliseconds(number);
+    } else if (flag == "--latency-us") {
+      options.latency = std::chrono::microseconds(number);
+    } else if (flag == "--fail-every") {
+      options.fail_every = number;
+    } else {
+      std::cerr << "Unknown option " << flag << "\n" << USAGE;
+      return 2;
+    }
+    if (!valid) {
+      std::cerr << "Invalid value of " << flag << ": " << value << "\n";
+      return 2;
+    }
+  }
+
+  //  Blocked before the daemon starts its threads, so only sigwait sees them
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try {
+    FakeDaemon daemon(path, options);
+    std::cout << "Listening on " << daemon.path() << std::endl;
+    int signal = 0;
+    sigwait(&signals, &signal);
+    std::cout << "Served " << daemon.requests() << " requests on "
+              << daemon.connections() << " connections" << std::endl;
+  } catch (std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -3,10 +3,25 @@
 
 #include "defines.hpp"
 
+#include <functional>
+
 namespace DockerClientpp {
 namespace Utility {
 class Archive {
  public:
+  /**
+   * @brief Receives the archive binary piece by piece
+   */
+  typedef std::function<void(const char *data, size_t size)> Writer;
+
+  /**
+   * @brief Supplies the archive binary piece by piece
+   *
+   * Fills at most size bytes into buffer and returns how many were filled,
+   * 0 marks the end of the archive
+   */
+  typedef std::function<size_t(char *buffer, size_t size)> Reader;
+
   Archive();
   ~Archive();
   /**
@@ -29,13 +44,42 @@ class Archive {
    */
   void writeToFd(const int fd);
 
+  /**
+   * @brief Stream the archive binary to a writer
+   *
+   * The archive is produced block by block while the files are read, so
+   * memory use does not depend on the archive size. An exception thrown by
+   * the writer aborts the archive and is rethrown to the caller
+   *
+   * @param writer called with each produced block
+   */
+  void writeTo(const Writer &writer);
+
   /**
    * @brief Get archive binary string
    * @return raw string of the archive
    */
   string getTar();
+
+  /**
+   * @brief Extract an archive held in memory
+   * @param tar_buffer raw string of the archive
+   * @param path directory the entries are extracted to
+   */
   static void extractTar(const string &tar_buffer, const string &path);
 
+  /**
+   * @brief Extract an archive while it is being read
+   *
+   * Entries are written to disk as soon as their data arrives, only one
+   * read block is held in memory at a time. An exception thrown by the
+   * reader aborts the extraction and is rethrown to the caller
+   *
+   * @param reader supplies the archive binary
+   * @param path directory the entries are extracted to
+   */
+  static void extractTar(const Reader &reader, const string &path);
+
  private:
   class Impl;
   unique_ptr<Impl> m_impl;
@@ -0,0 +1,91 @@
+#ifndef DOCKER_CLIENT_PP_ASYNCDOCKERCLIENT_H
+#define DOCKER_CLIENT_PP_ASYNCDOCKERCLIENT_H
+
+#include "AsyncHttpClient.hpp"
+#include "Results.hpp"
+#include "defines.hpp"
+
+#include <future>
+
+namespace DockerClientpp {
+/**
+ * @brief Docker client whose calls return immediately with a future
+ *
+ * All requests are multiplexed over the keep-alive connections of one
+ * AsyncHttpClient, so thousands of calls can be in flight from a single
+ * thread. Errors are delivered through the future, e.g. get() throws
+ * DockerOperationError when the daemon rejects the request.
+ *
+ * Results are the same as the ones of the matching DockerClient methods.
+ */
+class AsyncDockerClient {
+  /**
+   * @brief Disallow copy
+   */
+  AsyncDockerClient(const AsyncDockerClient &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  AsyncDockerClient &operator=(const AsyncDockerClient &) = delete;
+
+  class Impl;
+
+ public:
+  /**
+   * @brief Constructor
+   * @param type socket type that docker daemon use
+   * @param path path to the docker daemon socket, or IP:Port for TCP
+   * @param max_connections upper bound of concurrently open connections
+   */
+  AsyncDockerClient(const SOCK_TYPE type = SOCK_UNIX,
+                    const string &path = "/var/run/docker.sock",
+                    size_t max_connections = 64);
+
+  /**
+   * @brief Destructor, pending futures fail with SocketError
+   */
+  ~AsyncDockerClient();
+
+  /**
+   * @brief Set API version, e.g. "v1.24", applies to later calls
+   */
+  void setAPIVersion(const string &api);
+
+  std::future<vector<string>> listImages();
+  std::future<vector<string>> getRunningContainers();
+  std::future<string> createContainer(const json &config,
+                                      const string &name = "");
+  std::future<void> startContainer(const string &identifier);
+  std::future<void> stopContainer(const string &identifier);
+  std::future<void> killContainer(const string &identifier);
+  std::future<void> removeContainer(const string &identifier,
+                                    bool remove_volume = false,
+                                    bool force = false,
+                                    bool remove_link = false);
+  std::future<int> waitContainer(const string &identifier,
+                                 const string &condition = "not-running");
+  std::future<string> inspectContainer(const string &identifier);
+  std::future<ContainerInfo> inspectContainerInfo(const string &identifier);
+  std::future<string> getLongId(const string &name);
+  std::future<void> updateContainer(const string &identifier,
+                                    const json &config);
+  std::future<string> getContainerStats(const string &identifier);
+  std::future<StatsSample> getContainerStatsSample(const string &identifier);
+  std::future<string> getLogs(const string &identifier, bool std_out = true,
+                              bool std_err = true, int tail = -1);
+  std::future<string> createExecution(const string &identifier,
+                                      const json &config);
+  std::future<string> inspectExecution(const string &id);
+  std::future<ExecInfo> inspectExecutionInfo(const string &id);
+
+  /**
+   * @brief Counts of fresh and reused connections over all calls
+   */
+  Http::ConnectionStats getConnectionStats() const;
+
+ private:
+  unique_ptr<Impl> m_impl;
+};
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_ASYNCDOCKERCLIENT_H */
@@ -0,0 +1,83 @@
+#ifndef DOCKER_CLIENT_PP_ASYNCHTTPCLIENT_H
+#define DOCKER_CLIENT_PP_ASYNCHTTPCLIENT_H
+
+#include "Exceptions.hpp"
+#include "Request.hpp"
+#include "Response.hpp"
+#include "SimpleHttpClient.hpp"
+#include "defines.hpp"
+
+#include <exception>
+#include <functional>
+
+namespace DockerClientpp {
+namespace Http {
+/**
+ * @brief Non-blocking http client driven by an epoll event loop
+ *
+ * Requests are handed to a background thread which keeps up to
+ * max_connections keep-alive connections to the daemon and multiplexes
+ * every request in flight over them. Requests beyond that wait in
+ * submission order for the next free connection. When a kept-alive
+ * connection fails before any response byte arrived, GET, PUT and DELETE
+ * requests are sent once more over another connection, a POST only if none
+ * of it had been written. While the daemon's listen backlog is full, new
+ * connections are tried again after a short backoff.
+ *
+ * Completion callbacks run on the event loop thread, they must return
+ * quickly and must not wait for another request of the same client.
+ */
+class AsyncHttpClient {
+  /**
+   * @brief Disallow copy
+   */
+  AsyncHttpClient(const AsyncHttpClient &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  AsyncHttpClient &operator=(const AsyncHttpClient &) = delete;
+
+  class Impl;
+
+ public:
+  /**
+   * @brief Called once per request, with either the response or the error
+   *        that prevented it
+   */
+  typedef std::function<void(shared_ptr<Response> response,
+                             std::exception_ptr error)>
+      CompletionCallback;
+
+  /**
+   * @brief Constructor, starts the event loop thread
+   * @param type socket type that docker daemon use
+   * @param path path to the docker daemon socket
+   * @param max_connections upper bound of concurrently open connections
+   */
+  AsyncHttpClient(const SOCK_TYPE type, const string &path,
+                  size_t max_connections = 64);
+
+  /**
+   * @brief Destructor, requests still pending fail with SocketError
+   */
+  ~AsyncHttpClient();
+
+  /**
+   * @brief Queue a request, returns immediately
+   * @param request request to be sent, its body is sent as is
+   * @param callback called on the event loop thread when the request ends
+   */
+  void send(const Request &request, const CompletionCallback &callback);
+
+  /**
+   * @brief Counts of fresh and reused connections over all requests
+   */
+  ConnectionStats getConnectionStats() const;
+
+ private:
+  unique_ptr<Impl> m_impl;
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_ASYNCHTTPCLIENT_H */
@@ -0,0 +1,111 @@
+#ifndef DOCKER_CLIENT_PP_CONNECTIONPOOL_H
+#define DOCKER_CLIENT_PP_CONNECTIONPOOL_H
+
+#include "SimpleHttpClient.hpp"
+#include "defines.hpp"
+
+#include <chrono>
+
+namespace DockerClientpp {
+namespace Http {
+/**
+ * @brief Sizing and expiry options of a ConnectionPool
+ *
+ * Expiry is lazy, the pool has no timer: connections idle for longer than
+ * idle_timeout are closed the next time acquire() or a release runs, and
+ * one is never handed out once it has been idle that long. Until the pool
+ * is used again their sockets stay open
+ */
+struct PoolOptions {
+  size_t min_size = 1;  ///<  Connections kept even when they are idle
+  size_t max_size = 8;  ///<  Upper bound of concurrently open connections
+  std::chrono::milliseconds idle_timeout =
+      std::chrono::seconds(30);  ///<  Idle time after which one is not reused
+  shared_ptr<Recorder> recorder;  ///<  Record the traffic of every connection
+  shared_ptr<Replayer> replayer;  ///<  Serve every connection from a recording
+  Timeouts timeouts;  ///<  Time limits of each request on every connection
+};
+
+/**
+ * @brief Thread safe pool of persistent connections to the docker daemon
+ *
+ * Each pooled connection is a SimpleHttpClient keeping its socket alive.
+ * Threads check a connection out with acquire() and it goes back to the
+ * pool when the returned Lease is destroyed. When all connections are busy
+ * and the pool is at max_size, callers wait and are served in the order
+ * they arrived.
+ */
+class ConnectionPool {
+  /**
+   * @brief Disallow copy
+   */
+  ConnectionPool(const ConnectionPool &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+  class Impl;
+
+ public:
+  /**
+   * @brief Exclusive handle to a pooled connection
+   */
+  class Lease {
+   public:
+    Lease(Lease &&) = default;
+    ~Lease();
+    SimpleHttpClient *operator->() const {
+      return client.get();
+    }
+    SimpleHttpClient &operator*() const {
+      return *client;
+    }
+
+   private:
+    friend class ConnectionPool;
+    Lease(Impl *pool, unique_ptr<SimpleHttpClient> client);
+    Impl *pool;
+    unique_ptr<SimpleHttpClient> client;
+  };
+
+  /**
+   * @brief Constructor, no connection is opened until it is used
+   * @param type socket type that docker daemon use
+   * @param path path to the docker daemon socket
+   * @param options pool sizing options
+   */
+  ConnectionPool(const SOCK_TYPE type, const string &path,
+                 const PoolOptions &options = PoolOptions());
+  ~ConnectionPool();
+
+  /**
+   * @brief Check out a connection, blocks while the pool is exhausted
+   * @return lease that returns the connection to the pool when destroyed
+   */
+  Lease acquire();
+
+  /**
+   * @brief Number of connections currently owned by the pool
+   *
+   * Counts both idle and checked out connections
+   */
+  size_t size() const;
+
+  /**
+   * @brief Number of connections waiting in the pool
+   */
+  size_t idle() const;
+
+  /**
+   * @brief Upper bound of concurrently open connections
+   */
+  size_t maxSize() const;
+
+ private:
+  unique_ptr<Impl> m_impl;
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_CONNECTIONPOOL_H */
@@ -0,0 +1,182 @@
+#ifndef DOCKER_CLIENT_PP_CORODOCKERCLIENT_H
+#define DOCKER_CLIENT_PP_CORODOCKERCLIENT_H
+
+#if __cplusplus < 202002L
+#error "CoroDockerClient.hpp requires C++20, build with ENABLE_COROUTINES"
+#endif
+
+#include "AsyncHttpClient.hpp"
+#include "Operations.hpp"
+#include "defines.hpp"
+
+#include <coroutine>
+#include <optional>
+
+namespace DockerClientpp {
+/**
+ * @brief Common part of the awaitables returned by CoroDockerClient
+ *
+ * The request is sent when the awaiting coroutine suspends, and the
+ * coroutine is resumed on the event loop thread of the client once the
+ * response has been checked and converted.
+ */
+template <class T>
+class DockerAwaitableBase {
+ public:
+  typedef T (*Converter)(const Http::Request &, Http::Response &);
+
+  DockerAwaitableBase(Http::AsyncHttpClient &client, Http::Request request,
+                      Converter convert)
+      : client(client), request(std::move(request)), convert(convert) {}
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    //  The frame may be resumed before send() returns, nothing of this
+    //  object is touched after it
+    client.send(request, [this, handle](shared_ptr<Http::Response> response,
+                                        std::exception_ptr error) {
+      if (error) {
+        this->error = error;
+      } else {
+        try {
+          store(*response);
+        } catch (...) {
+          this->error = std::current_exception();
+        }
+      }
+      handle.resume();
+    });
+  }
+
+ protected:
+  virtual void store(Http::Response &response) = 0;
+
+  Http::AsyncHttpClient &client;
+  Http::Request request;
+  Converter convert;
+  std::exception_ptr error;
+};
+
+/**
+ * @brief Awaitable result of a CoroDockerClient call
+ *
+ * `co_await` yields the same value the matching DockerClient method
+ * returns, or throws the same exception
+ */
+template <class T>
+class DockerAwaitable : public DockerAwaitableBase<T> {
+ public:
+  using DockerAwaitableBase<T>::DockerAwaitableBase;
+
+  T await_resume() {
+    if (this->error) std::rethrow_exception(this->error);
+    return std::move(*value);
+  }
+
+ private:
+  void store(Http::Response &response) override {
+    value.emplace(this->convert(this->request, response));
+  }
+
+  std::optional<T> value;
+};
+
+template <>
+class DockerAwaitable<void> : public DockerAwaitableBase<void> {
+ public:
+  using DockerAwaitableBase<void>::DockerAwaitableBase;
+
+  void await_resume() {
+    if (error) std::rethrow_exception(error);
+  }
+
+ private:
+  void store(Http::Response &response) override {
+    convert(request, response);
+  }
+};
+
+/**
+ * @brief Docker client with co_await-able operations
+ *
+ * Built on the same AsyncHttpClient event loop as AsyncDockerClient, so
+ * any number of coroutines can have calls in flight without a thread per
+ * call. Any coroutine type can await the returned objects.
+ *
+ * Note: coroutines are resumed on the event loop thread, they should hand
+ * long running or blocking work to another thread.
+ */
+class CoroDockerClient {
+  /**
+   * @brief Disallow copy
+   */
+  CoroDockerClient(const CoroDockerClient &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  CoroDockerClient &operator=(const CoroDockerClient &) = delete;
+
+ public:
+  /**
+   * @brief Constructor
+   * @param type socket type that docker daemon use
+   * @param path path to the docker daemon socket, or IP:Port for TCP
+   * @param max_connections upper bound of concurrently open connections
+   */
+  CoroDockerClient(const SOCK_TYPE type = SOCK_UNIX,
+                   const string &path = "/var/run/docker.sock",
+                   size_t max_connections = 64);
+
+  /**
+   * @brief Set API version, e.g. "v1.24", applies to later calls
+   */
+  void setAPIVersion(const string &api);
+
+  DockerAwaitable<vector<string>> listImages();
+  DockerAwaitable<vector<string>> getRunningContainers();
+  DockerAwaitable<string> createContainer(const json &config,
+                                          const string &name = "");
+  DockerAwaitable<void> startContainer(const string &identifier);
+  DockerAwaitable<void> stopContainer(const string &identifier);
+  DockerAwaitable<void> killContainer(const string &identifier);
+  DockerAwaitable<void> removeContainer(const string &identifier,
+                                        bool remove_volume = false,
+                                        bool force = false,
+                                        bool remove_link = false);
+  DockerAwaitable<int> waitContainer(const string &identifier,
+                                     const string &condition = "not-running");
+  DockerAwaitable<string> inspectContainer(const string &identifier);
+  DockerAwaitable<ContainerInfo> inspectContainerInfo(
+      const string &identifier);
+  DockerAwaitable<string> getLongId(const string &name);
+  DockerAwaitable<void> updateContainer(const string &identifier,
+                                        const json &config);
+  DockerAwaitable<string> getContainerStats(const string &identifier);
+  DockerAwaitable<StatsSample> getContainerStatsSample(
+      const string &identifier);
+  DockerAwaitable<string> getLogs(const string &identifier,
+                                  bool std_out = true, bool std_err = true,
+                                  int tail = -1);
+  DockerAwaitable<string> createExecution(const string &identifier,
+                                          const json &config);
+  DockerAwaitable<string> inspectExecution(const string &id);
+  DockerAwaitable<ExecInfo> inspectExecutionInfo(const string &id);
+
+  /**
+   * @brief Counts of fresh and reused connections over all calls
+   */
+  Http::ConnectionStats getConnectionStats() const;
+
+ private:
+  template <class Operation, class... Args>
+  DockerAwaitable<typename Operation::Result> call(Args &&... args);
+
+  Http::AsyncHttpClient client;
+  string api_version;
+};
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_CORODOCKERCLIENT_H */
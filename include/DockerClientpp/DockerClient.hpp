@@ -2,13 +2,46 @@
 #define DOCKER_CLIENT_PP_DOCKERCLIENT_H
 
 #include "Archive.hpp"
+#include "ConnectionPool.hpp"
+#include "Event.hpp"
 #include "ExecRet.hpp"
+#include "Results.hpp"
 #include "Response.hpp"
 #include "SimpleHttpClient.hpp"
 #include "defines.hpp"
 
+#include <exception>
+
 namespace DockerClientpp {
 
+/**
+ * @brief Receives one decoded stats sample, return false to stop streaming
+ */
+typedef std::function<bool(const json &sample)> StatsCallback;
+
+/**
+ * @brief Options of DockerClient::streamLogs()
+ */
+struct LogOptions {
+  bool std_out = true;      ///<  Include stdout
+  bool std_err = true;      ///<  Include stderr
+  bool follow = false;      ///<  Keep streaming new output until stopped
+  bool timestamps = false;  ///<  Prefix every line with its timestamp
+  long since = 0;           ///<  Only logs after this UNIX time, 0 for all
+  long until = 0;           ///<  Only logs before this UNIX time, 0 for all
+  int tail = -1;            ///<  Number of lines from the end, -1 for all
+  bool tty = false;  ///<  Container runs with Tty, output is not multiplexed
+};
+
+/**
+ * @brief Outcome of one container of DockerClient::inspectContainers()
+ */
+struct InspectResult {
+  string id;                 ///<  Container's ID or name as requested
+  string body;               ///<  Inspect output, empty if it failed
+  std::exception_ptr error;  ///<  Why the inspect failed, null on success
+};
+
 /**
  * @brief Docker client class
  */
@@ -30,17 +63,27 @@ class DockerClient {
     public:
     /**
      * @brief Constructor, create a socket file
+     *
+     * Requests go through a pool of persistent connections, so one client
+     * can be shared by several threads
+     *
      * @param type socket type that docker daemon use
      * @param path path to the docker daemon socket
      *        if type is TCP, path might be a IP to docker daemon server
+     * @param pool_options size and idle timeout of the connection pool,
+     *        the recording every connection writes to or replays, and the
+     *        request timeouts. Operations made of several requests, like
+     *        executeCommand(), share one total timeout between them
      */
     DockerClient(const SOCK_TYPE type = SOCK_UNIX,
-                const string &path = "/var/run/docker.sock");
+                const string &path = "/var/run/docker.sock",
+                const Http::PoolOptions &pool_options = Http::PoolOptions());
 
     /**
      * @brief Set Docker daemon API version
      *
-     * The default api version is v1.24
+     * The default api version is v1.24. Not thread safe, set it before the
+     * client is shared between threads
      *
      * @param api api version to be set. e.g. api = "v1.24"
      */
@@ -116,6 +159,20 @@ class DockerClient {
      */
     string startExecution(const string &id, const json &config = {});
 
+    /**
+     * @brief Start a execution instance and stream its output
+     *
+     * The execution must be set up without Tty, so that stdout and stderr
+     * are multiplexed and can be told apart
+     *
+     * @param id Execution instance ID
+     * @param config configuration
+     * @param sink receives output pieces with the stream they belong to,
+     *        return false to stop reading
+     */
+    void startExecution(const string &id, const json &config,
+                        const Http::FrameSink &sink);
+
     /**
      * @brief Get statistics for a execution instance
      *
@@ -124,6 +181,44 @@ class DockerClient {
      */
     string getContainerStats(const string &id);
 
+    /**
+     * @brief Get one statistics sample of a container, decoded
+     *
+     * Only the fields of StatsSample are read from the response, no json
+     * document is built
+     *
+     * @param id Container's ID or name
+     * @return CPU, memory, network and pids counters
+     */
+    StatsSample getContainerStatsSample(const string &id);
+
+    /**
+     * @brief Stream statistics of a container
+     *
+     * Keeps one dedicated connection open and decodes each sample as soon as
+     * the daemon sends it, roughly once per second. Returns when the
+     * callback returns false or the container stops
+     *
+     * @param id Container's ID or name
+     * @param callback receives each stats sample
+     */
+    void streamContainerStats(const string &id,
+                              const StatsCallback &callback);
+
+    /**
+     * @brief Subscribe to the events of the docker daemon
+     *
+     * Keeps one dedicated connection open and decodes each event as soon as
+     * the daemon sends it. When the connection drops, a new one resumes
+     * right after the last event seen. Returns when the callback returns
+     * false, or once options.until is reached
+     *
+     * @param options time range, filters and reconnect policy
+     * @param callback receives each event
+     */
+    void streamEvents(const EventOptions &options,
+                      const EventCallback &callback);
+
     /**
      * @brief Inspect a execution instance
      *
@@ -132,6 +227,14 @@ class DockerClient {
      */
     string inspectExecution(const string &id);
 
+    /**
+     * @brief Inspect a execution instance, decoded
+     *
+     * @param id Execution instance ID
+     * @return whether it runs, its exit code and pid
+     */
+    ExecInfo inspectExecutionInfo(const string &id);
+
     /**
      * @brief Update the configurations of already created container 
      *
@@ -150,7 +253,8 @@ class DockerClient {
      *
      * @param identifier Container's ID or name
      * @param cmd Executing command with parameters in vector
-     * @return
+     * @return exit code, with stdout and stderr both separate and
+     *         interleaved
      * @sa createContainer()
      */
     ExecRet executeCommand(const string &identifier, const vector<string> &cmd);
@@ -193,9 +297,85 @@ class DockerClient {
 
     string getLogs(const string &id,bool stdoutFlag=true, bool stderrFlag=true, int tail=-1);
 
-    string inspectContainer(const string &id) ;
+    /**
+     * @brief Stream container logs with stdout and stderr kept apart
+     *
+     * Output is handed to the sink as it arrives, so memory use does not
+     * depend on the log size. With follow set, the call keeps its own
+     * connection open and returns when the sink returns false or the
+     * container stops
+     *
+     * @param id Container's ID or name
+     * @param options which logs to get
+     * @param sink receives log output with the stream it belongs to
+     */
+    void streamLogs(const string &id, const LogOptions &options,
+                    const Http::FrameSink &sink);
+
+    /**
+     * @brief Inspect a container
+     *
+     * With the inspect cache enabled, a cached result is returned until
+     * /events reports a change of the container
+     *
+     * @param id Container's ID or name
+     * @param bypass_cache always ask the daemon
+     * @return Inspect output
+     */
+    string inspectContainer(const string &id, bool bypass_cache = false);
+
+    /**
+     * @brief Inspect a container, decoded
+     *
+     * Only the fields of ContainerInfo are read from the response, no json
+     * document is built. Not served by the inspect cache
+     *
+     * @param id Container's ID or name
+     * @return identity and state of the container
+     */
+    ContainerInfo inspectContainerInfo(const string &id);
+
+    /**
+     * @brief Inspect many containers over the connection pool
+     *
+     * Up to concurrency pooled connections are used at once, never more
+     * than the pool's max_size, and requests are pipelined on each of them.
+     * A failed inspect does not stop the others, its error is kept in the
+     * matching result, as is the error of a worker that got no connection.
+     *
+     * @param ids Containers' IDs or names
+     * @param concurrency maximum number of connections used at once
+     * @return one result per id, in the order of ids
+     */
+    std::vector<InspectResult> inspectContainers(const vector<string> &ids,
+                                                 size_t concurrency = 4);
 
-    string getLongId(const std::string &name);
+    /**
+     * @brief Get the full ID of a container
+     * @param name Container's ID or name
+     * @param bypass_cache always ask the daemon
+     */
+    string getLongId(const std::string &name, bool bypass_cache = false);
+
+    /**
+     * @brief Turn the inspect cache on or off
+     *
+     * While enabled, inspectContainer() and getLongId() results are kept in
+     * memory and dropped when /events reports any change of the container.
+     * A background thread keeps the events subscription open, results are
+     * only cached once it is live. If it fails the cache turns itself off,
+     * see inspectCacheError(). Disabled by default
+     *
+     * @param enable whether to cache inspect results
+     */
+    void enableInspectCache(bool enable = true);
+
+    /**
+     * @brief Why the inspect cache turned itself off
+     * @return the error that ended the events subscription, nullptr while
+     *         the cache runs or after enableInspectCache() was called again
+     */
+    std::exception_ptr inspectCacheError();
 
     std::vector<std::string> getRunningContainers();
     private:
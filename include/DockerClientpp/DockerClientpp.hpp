@@ -1,6 +1,7 @@
 #ifndef DOCKER_CLIENT_PP_DOCKERCLIENTPP_H
 #define DOCKER_CLIENT_PP_DOCKERCLIENTPP_H
 
+#include "AsyncDockerClient.hpp"
 #include "DockerClient.hpp"
 
 namespace DockerClientpp {}
@@ -0,0 +1,46 @@
+#ifndef DOCKER_CLIENT_PP_EVENT_H
+#define DOCKER_CLIENT_PP_EVENT_H
+
+#include "defines.hpp"
+
+#include <chrono>
+#include <functional>
+
+namespace DockerClientpp {
+
+/**
+ * @brief One event reported by the docker daemon
+ */
+struct Event {
+  string type;    ///<  Kind of object, e.g. "container", "image", "network"
+  string action;  ///<  What happened, e.g. "start", "die", "destroy"
+  string id;      ///<  ID of the object the event is about
+  std::map<string, string> attributes;  ///<  Actor attributes, e.g. "name"
+  string scope;         ///<  "local" or "swarm", empty on older daemons
+  long time = 0;        ///<  UNIX time of the event
+  long long time_nano = 0;  ///<  UNIX time of the event in nanoseconds
+};
+
+/**
+ * @brief Options of DockerClient::streamEvents()
+ */
+struct EventOptions {
+  long since = 0;  ///<  Replay events after this UNIX time, 0 for new only
+  long until = 0;  ///<  Stop at this UNIX time, 0 to stream until stopped
+  /**
+   * @brief Filters of the docker API, e.g. {{"type", {"container"}}}
+   */
+  std::map<string, vector<string>> filters;
+  bool reconnect = true;  ///<  Resume after a dropped connection
+  std::chrono::milliseconds reconnect_delay =
+      std::chrono::seconds(1);  ///<  Wait before reconnecting
+};
+
+/**
+ * @brief Receives each event, return false to stop streaming
+ */
+typedef std::function<bool(const Event &event)> EventCallback;
+
+}  // namespace  DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_EVENT_H */
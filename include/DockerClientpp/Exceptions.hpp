@@ -36,6 +36,17 @@ class SocketError : public Exception {
   explicit SocketError(const string &what) : Exception(what) {}
 };
 
+/**
+ * @brief A connect, write or read did not finish before its deadline
+ *
+ * The connection it happened on is closed, the request may or may not have
+ * reached the daemon
+ */
+class TimeoutError : public SocketError {
+ public:
+  explicit TimeoutError(const string &what) : SocketError(what) {}
+};
+
 class SocketEOFError : public SocketError {
  public:
   SocketEOFError(int read) : SocketError("EOF"), read(read) {}
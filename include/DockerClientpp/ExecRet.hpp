@@ -5,9 +5,14 @@
 
 namespace DockerClientpp {
 
+/**
+ * @brief Result of DockerClient::executeCommand()
+ */
 struct ExecRet {
-  int ret_code;
-  string output;
+  int ret_code;    ///<  Exit code of the command
+  string output;   ///<  stdout and stderr interleaved in arrival order
+  string std_out;  ///<  Output written to stdout only
+  string std_err;  ///<  Output written to stderr only
 };
 
 }  // namespace  DockerClientpp
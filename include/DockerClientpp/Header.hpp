@@ -0,0 +1,93 @@
+#ifndef DOCKER_CLIENT_PP_HEADER_H
+#define DOCKER_CLIENT_PP_HEADER_H
+
+#include "defines.hpp"
+
+#include <initializer_list>
+#include <utility>
+
+namespace DockerClientpp {
+namespace Http {
+/**
+ * @brief Fields of a http request or response header
+ *
+ * Fields are kept in arrival order in one flat vector and names are
+ * matched case-insensitively. A header has a handful of fields, so a
+ * linear scan is cheaper than any map, and nothing is allocated per lookup.
+ */
+class Header {
+ public:
+  typedef std::pair<string, string> Field;
+  typedef vector<Field>::iterator iterator;
+  typedef vector<Field>::const_iterator const_iterator;
+
+  Header() = default;
+  Header(std::initializer_list<Field> fields);
+
+  /**
+   * @brief Find the first field with the given name, ignoring case
+   * @return iterator to the field, or end()
+   */
+  iterator find(const char *name);
+  const_iterator find(const char *name) const;
+  iterator find(const string &name);
+  const_iterator find(const string &name) const;
+
+  /**
+   * @brief Value of the field with the given name, added empty if missing
+   */
+  string &operator[](const string &name);
+
+  /**
+   * @brief Append a field without looking for an existing one
+   */
+  void add(string name, string value);
+
+  /**
+   * @brief Parse one "Name: value" line, without line ending, and append it
+   *
+   * Optional whitespace around the value is dropped. Throws ParseError if
+   * the line has no colon. Meant for headers read line by line, such as
+   * Utility::loadHeader(). Response heads of the http clients do not come
+   * through here: ResponseParser parses them in place in the receive
+   * buffer and ResponseParser::fillResponse() adds the fields
+   *
+   * @param begin first character of the line
+   * @param end one past the last character of the line
+   */
+  void parseLine(const char *begin, const char *end);
+
+  /**
+   * @brief Remove every field with the given name
+   * @return number of removed fields
+   */
+  size_t erase(const string &name);
+
+  iterator begin() { return fields.begin(); }
+  iterator end() { return fields.end(); }
+  const_iterator begin() const { return fields.begin(); }
+  const_iterator end() const { return fields.end(); }
+  size_t size() const { return fields.size(); }
+  bool empty() const { return fields.empty(); }
+  void clear() { fields.clear(); }
+  void reserve(size_t size) { fields.reserve(size); }
+
+ private:
+  const_iterator findName(const char *name, size_t size) const;
+
+  vector<Field> fields;
+};
+
+/**
+ * @brief Convert to a json object of name to value, for code that still
+ *        handles headers as json
+ */
+void to_json(json &j, const Header &header);
+/**
+ * @brief Load from a json object of name to string value
+ */
+void from_json(const json &j, Header &header);
+}  // namespace Http
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_HEADER_H */
@@ -0,0 +1,186 @@
+#ifndef DOCKER_CLIENT_PP_OPERATIONS_H
+#define DOCKER_CLIENT_PP_OPERATIONS_H
+
+#include "Request.hpp"
+#include "Response.hpp"
+#include "Results.hpp"
+#include "defines.hpp"
+
+#include <initializer_list>
+
+namespace DockerClientpp {
+/**
+ * @brief Transport independent description of docker API calls
+ *
+ * Each operation knows how to build its Http::Request and how to turn the
+ * Http::Response into a result, so the blocking DockerClient and the
+ * AsyncDockerClient share them and only differ in how bytes are moved.
+ *
+ * Every operation has the form
+ * @code
+ * struct Operation {
+ *   typedef ... Result;
+ *   static Http::Request request(arguments...);
+ *   static Result result(const Http::Request &, Http::Response &);
+ * };
+ * @endcode
+ * result() throws DockerOperationError on an unexpected status code. It
+ * may move the body out of the response instead of copying it.
+ */
+namespace Operations {
+/**
+ * @brief Fill the headers every docker API request carries
+ *
+ * Fields already set in the request header are kept
+ *
+ * @param request request to be completed
+ * @param api_version docker API version, e.g. "v1.24"
+ */
+void prepare(Http::Request &request, const string &api_version);
+
+/**
+ * @brief Throw DockerOperationError unless the status code is accepted
+ */
+void checkStatus(const Http::Request &request, const Http::Response &response,
+                 std::initializer_list<int> accepted);
+
+struct ListImages {
+  typedef vector<string> Result;
+  static Http::Request request();
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct GetRunningContainers {
+  typedef vector<string> Result;
+  static Http::Request request();
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct CreateContainer {
+  typedef string Result;
+  static Http::Request request(const json &config, const string &name = "");
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct StartContainer {
+  typedef void Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct StopContainer {
+  typedef void Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct KillContainer {
+  typedef void Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct RemoveContainer {
+  typedef void Result;
+  static Http::Request request(const string &identifier,
+                               bool remove_volume = false, bool force = false,
+                               bool remove_link = false);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct WaitContainer {
+  typedef int Result;
+  static Http::Request request(const string &identifier,
+                               const string &condition = "not-running");
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct InspectContainer {
+  typedef string Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct InspectContainerInfo {
+  typedef ContainerInfo Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct GetLongId {
+  typedef string Result;
+  static Http::Request request(const string &name);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct UpdateContainer {
+  typedef void Result;
+  static Http::Request request(const string &identifier, const json &config);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct GetContainerStats {
+  typedef string Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct GetContainerStatsSample {
+  typedef StatsSample Result;
+  static Http::Request request(const string &identifier);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct GetLogs {
+  typedef string Result;
+  static Http::Request request(const string &identifier, bool std_out = true,
+                               bool std_err = true, int tail = -1);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct CreateExecution {
+  typedef string Result;
+  static Http::Request request(const string &identifier, const json &config);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct StartExecution {
+  typedef string Result;
+  static Http::Request request(const string &id, const json &config);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct InspectExecution {
+  typedef string Result;
+  static Http::Request request(const string &id);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+
+struct InspectExecutionInfo {
+  typedef ExecInfo Result;
+  static Http::Request request(const string &id);
+  static Result result(const Http::Request &request,
+                       Http::Response &response);
+};
+}  // namespace Operations
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_OPERATIONS_H */
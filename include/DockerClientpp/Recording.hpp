@@ -0,0 +1,158 @@
+#ifndef DOCKER_CLIENT_PP_RECORDING_H
+#define DOCKER_CLIENT_PP_RECORDING_H
+
+#include "defines.hpp"
+
+#include <cstdint>
+
+namespace DockerClientpp {
+/**
+ * @brief Writes the traffic of sockets to a recording file
+ *
+ * A Socket given a Recorder reports every connect, every block of bytes it
+ * sends or receives and every close, each with the time it happened. The
+ * file is a compact binary log that a Replayer serves back. One Recorder
+ * can be shared by any number of sockets and threads.
+ *
+ * File layout, integers are LEB128 varints:
+ *   - magic "DCPPREC1"
+ *   - records: kind byte, connection number, microseconds since the
+ *     previous record, then for sent and received blocks the size and the
+ *     bytes. A received block of size 0 is the peer closing the connection
+ */
+class Recorder {
+  /**
+   * @brief Disallow copy
+   */
+  Recorder(const Recorder &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  Recorder &operator=(const Recorder &) = delete;
+
+ public:
+  /**
+   * @brief Create the recording, replacing an existing file
+   * @param path path of the recording file
+   */
+  explicit Recorder(const string &path);
+
+  /**
+   * @brief Flush and close the recording
+   */
+  ~Recorder();
+
+  /**
+   * @brief Record a new connection
+   * @return number identifying the connection in the recording
+   */
+  uint32_t connected();
+
+  /**
+   * @brief Record bytes sent on a connection
+   */
+  void sent(uint32_t connection, const char *data, size_t size);
+
+  /**
+   * @brief Record bytes received on a connection, 0 bytes for end of file
+   */
+  void received(uint32_t connection, const char *data, size_t size);
+
+  /**
+   * @brief Record the client closing a connection
+   */
+  void closed(uint32_t connection);
+
+  /**
+   * @brief Write buffered records to the file
+   */
+  void flush();
+
+ private:
+  class Impl;
+  unique_ptr<Impl> m_impl;
+};
+
+/**
+ * @brief Serves the connections of a recording instead of a daemon
+ *
+ * Every connect() of a Socket given a Replayer takes the next recorded
+ * connection. What the client sends is not compared with the recording,
+ * so a newer client version producing slightly different requests can be
+ * replayed against traffic captured with an older one. Received blocks are
+ * returned in order, each after the delay the daemon took to produce it,
+ * multiplied by the latency scale. A connection looks reusable to the
+ * client exactly when the recorded client reused it.
+ */
+class Replayer {
+  /**
+   * @brief Disallow copy
+   */
+  Replayer(const Replayer &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  Replayer &operator=(const Replayer &) = delete;
+
+ public:
+  /**
+   * @brief Load a recording
+   *
+   * Throws ParseError if the file is not a complete recording
+   *
+   * @param path path of the recording file
+   * @param latency_scale factor applied to the recorded delays, 1 keeps
+   *        the original timing and 0 replays as fast as possible
+   */
+  explicit Replayer(const string &path, double latency_scale = 1.0);
+  ~Replayer();
+
+  /**
+   * @brief Take the next recorded connection
+   *
+   * Throws SocketError when every recorded connection has been taken
+   *
+   * @return number of the connection
+   */
+  uint32_t connect();
+
+  /**
+   * @brief Replay the client sending a request on a connection
+   */
+  void send(uint32_t connection);
+
+  /**
+   * @brief Replay receiving on a connection
+   *
+   * Waits for the scaled recorded delay before the first bytes of each
+   * received block
+   *
+   * @return size of data received, 0 at the recorded end of the connection
+   */
+  size_t receive(uint32_t connection, char *buffer, size_t size);
+
+  /**
+   * @brief Whether the recorded client sent another request on the
+   *        connection, used to answer Socket::isAlive()
+   */
+  bool reusable(uint32_t connection);
+
+  /**
+   * @brief End a connection, later receives return end of file
+   *
+   * Safe to call from another thread
+   */
+  void close(uint32_t connection);
+
+  /**
+   * @brief Number of connections in the recording
+   */
+  size_t connections() const;
+
+ private:
+  class Impl;
+  unique_ptr<Impl> m_impl;
+};
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_RECORDING_H */
@@ -0,0 +1,22 @@
+#ifndef DOCKER_CLIENT_PP_REQUEST_H
+#define DOCKER_CLIENT_PP_REQUEST_H
+
+#include "Header.hpp"
+#include "defines.hpp"
+
+namespace DockerClientpp {
+namespace Http {
+/**
+ * @brief Http request class
+ */
+struct Request {
+  string method;           ///<  Method of the request, e.g. "GET"
+  Uri uri;                 ///<  Uri of the request, without query
+  Header header;           ///<  Header of the request
+  QueryParam query_param;  ///<  Query parameters appended to the uri
+  string body;             ///<  Body of the request
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_REQUEST_H */
@@ -1,6 +1,7 @@
 #ifndef DOCKER_CLIENT_PP_RESPONSE_H
 #define DOCKER_CLIENT_PP_RESPONSE_H
 
+#include "Header.hpp"
 #include "defines.hpp"
 
 namespace DockerClientpp {
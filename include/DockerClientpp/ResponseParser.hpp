@@ -0,0 +1,137 @@
+#ifndef DOCKER_CLIENT_PP_RESPONSEPARSER_H
+#define DOCKER_CLIENT_PP_RESPONSEPARSER_H
+
+#include "Response.hpp"
+#include "StringRef.hpp"
+#include "defines.hpp"
+
+namespace DockerClientpp {
+namespace Http {
+/**
+ * @brief Resumable parser of a http response head, working in place
+ *
+ * The status line and header fields are parsed straight from the receive
+ * buffer of the connection, nothing is copied until fillResponse(). The
+ * buffer may grow or move between calls as long as it still starts at the
+ * first byte of the response, lines parsed by earlier calls are not
+ * scanned again. Used by both SimpleHttpClient and AsyncHttpClient.
+ *
+ * @code
+ * ResponseParser parser;
+ * while (!parser.parseHead(buffer.data(), buffer.size())) {
+ *   //  receive more bytes into buffer
+ * }
+ * parser.fillResponse(response);
+ * //  the body starts at buffer.data() + parser.headSize()
+ * @endcode
+ */
+class ResponseParser {
+ public:
+  /**
+   * @brief How the end of the body is found
+   */
+  enum BodyMode {
+    NO_BODY,         ///<  1xx, 204 and 304 responses
+    CONTENT_LENGTH,  ///<  contentLength() bytes
+    CHUNKED,         ///<  Chunked transfer encoding
+    UNTIL_EOF        ///<  Until the peer closes the connection
+  };
+
+  ResponseParser();
+
+  /**
+   * @brief Forget the previous response
+   */
+  void reset();
+
+  /**
+   * @brief Parse the lines of the head completed by new data
+   *
+   * Throws ParseError on a malformed head or one larger than 64 KiB
+   *
+   * @param data first byte of the response
+   * @param size bytes received so far
+   * @return true once the empty line ending the head was parsed
+   */
+  bool parseHead(const char *data, size_t size);
+
+  /**
+   * @brief Size of the head including its empty line
+   */
+  size_t headSize() const {
+    return head_size;
+  }
+
+  int statusCode() const {
+    return status_code;
+  }
+  BodyMode bodyMode() const {
+    return body_mode;
+  }
+  size_t contentLength() const {
+    return content_length;
+  }
+  /**
+   * @brief Whether the response allows another request on the connection
+   */
+  bool keepAlive() const {
+    return keep_alive;
+  }
+
+  size_t fieldCount() const {
+    return fields.size();
+  }
+  /**
+   * @brief Name of a header field, valid while the parsed data is
+   */
+  StringRef fieldName(size_t index) const;
+  /**
+   * @brief Value of a header field, valid while the parsed data is
+   */
+  StringRef fieldValue(size_t index) const;
+
+  /**
+   * @brief Copy status code and header fields into the response
+   */
+  void fillResponse(Response &response) const;
+
+  /**
+   * @brief Length of the line at the start of data
+   * @return size including its CRLF, 0 if the line is not complete yet
+   */
+  static size_t lineSize(const char *data, size_t size);
+
+  /**
+   * @brief Parse a chunk-size line, chunk extensions are ignored
+   * @param line the line, with or without CRLF
+   * @return size of the chunk
+   */
+  static size_t parseChunkSize(StringRef line);
+
+ private:
+  struct FieldPosition {
+    size_t name;
+    size_t name_size;
+    size_t value;
+    size_t value_size;
+  };
+
+  void parseStatusLine(size_t begin, size_t end);
+  void parseField(size_t begin, size_t end);
+  void decideBodyMode();
+
+  const char *base;
+  //  Offset of the first line not parsed yet
+  size_t scanned;
+  size_t head_size;
+  bool status_parsed;
+  int status_code;
+  vector<FieldPosition> fields;
+  BodyMode body_mode;
+  size_t content_length;
+  bool keep_alive;
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_RESPONSEPARSER_H */
@@ -0,0 +1,75 @@
+#ifndef DOCKER_CLIENT_PP_RESULTS_H
+#define DOCKER_CLIENT_PP_RESULTS_H
+
+#include "defines.hpp"
+
+#include <cstdint>
+
+namespace DockerClientpp {
+
+/**
+ * @brief State part of a container inspect
+ */
+struct ContainerState {
+  string status;            ///<  e.g. "running", "exited"
+  bool running = false;     ///<  Whether the container is running
+  bool paused = false;      ///<  Whether the container is paused
+  bool restarting = false;  ///<  Whether the container is restarting
+  bool oom_killed = false;  ///<  Whether it was killed for lack of memory
+  bool dead = false;        ///<  Whether the container is dead
+  int pid = 0;              ///<  Pid of the main process, 0 if not running
+  int exit_code = 0;        ///<  Exit code of the last run
+  string error;             ///<  Error of the last run, if any
+  string started_at;        ///<  Time of the last start, RFC 3339
+  string finished_at;       ///<  Time of the last exit, RFC 3339
+};
+
+/**
+ * @brief Result of DockerClient::inspectContainerInfo()
+ */
+struct ContainerInfo {
+  string id;              ///<  Full ID of the container
+  string name;            ///<  Name of the container, with leading '/'
+  string image;           ///<  ID of the image the container runs
+  string created;         ///<  Creation time, RFC 3339
+  int restart_count = 0;  ///<  Number of restarts by the restart policy
+  ContainerState state;   ///<  Current state
+};
+
+/**
+ * @brief Result of DockerClient::inspectExecutionInfo()
+ */
+struct ExecInfo {
+  string id;              ///<  ID of the execution
+  string container_id;    ///<  ID of the container it runs in
+  bool running = false;   ///<  Whether the command is still running
+  int exit_code = 0;      ///<  Exit code, 0 while it is running
+  int pid = 0;            ///<  Pid of the command, 0 if not running
+};
+
+/**
+ * @brief CPU usage counters of a stats sample
+ */
+struct CpuUsage {
+  uint64_t total_usage = 0;   ///<  CPU time used by the container, in ns
+  uint64_t system_usage = 0;  ///<  CPU time used by the host, in ns
+  unsigned online_cpus = 0;   ///<  Number of CPUs, 0 on older daemons
+};
+
+/**
+ * @brief Result of DockerClient::getContainerStatsSample()
+ */
+struct StatsSample {
+  string read;                ///<  Time the sample was taken, RFC 3339
+  CpuUsage cpu;               ///<  CPU counters of this sample
+  CpuUsage precpu;            ///<  CPU counters of the previous sample
+  uint64_t memory_usage = 0;  ///<  Memory used, in bytes
+  uint64_t memory_limit = 0;  ///<  Memory limit, in bytes
+  uint64_t network_rx_bytes = 0;  ///<  Received bytes over all interfaces
+  uint64_t network_tx_bytes = 0;  ///<  Sent bytes over all interfaces
+  uint64_t pids = 0;              ///<  Number of processes
+};
+
+}  // namespace  DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_RESULTS_H */
@@ -2,20 +2,215 @@
 #define DOCKER_CLIENT_PP_SIMPLEHTTPCLIENT_H
 
 #include "Exceptions.hpp"
+#include "Recording.hpp"
+#include "Request.hpp"
 #include "Response.hpp"
 #include "Utility.hpp"
 #include "defines.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
 
 namespace DockerClientpp {
 namespace Http {
+/**
+ * @brief Counters of connections used by a SimpleHttpClient
+ */
+struct ConnectionStats {
+  size_t fresh = 0;   ///<  Requests that had to open a new connection
+  size_t reused = 0;  ///<  Requests served on a kept-alive connection
+};
+
+/**
+ * @brief Time limits of each request of a SimpleHttpClient, 0 for none
+ *
+ * A request that misses one of them fails with TimeoutError and its
+ * connection is closed. Requests that timed out are never sent again
+ */
+struct Timeouts {
+  std::chrono::milliseconds connect =
+      std::chrono::milliseconds(0);  ///<  Opening a new connection
+  std::chrono::milliseconds write =
+      std::chrono::milliseconds(0);  ///<  Sending the request
+  std::chrono::milliseconds first_byte =
+      std::chrono::milliseconds(0);  ///<  From sent request to response head
+  std::chrono::milliseconds total =
+      std::chrono::milliseconds(0);  ///<  Whole request, body included
+};
+
+/**
+ * @brief Shares one deadline between the requests made in its lifetime
+ *
+ * While a scope is alive, every request of any SimpleHttpClient on the
+ * same thread has to finish before the scope's deadline, on top of the
+ * client's own timeouts. Nested scopes can only shorten the deadline.
+ * Requests sent from other threads are not bounded unless those threads
+ * open a scope with the same deadline
+ */
+class DeadlineScope {
+  /**
+   * @brief Disallow copy
+   */
+  DeadlineScope(const DeadlineScope &) = delete;
+  /**
+   * @brief Disallow copy
+   */
+  DeadlineScope &operator=(const DeadlineScope &) = delete;
+
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * @brief Start a budget counted from now
+   * @param budget time the requests may take together, 0 for no limit
+   */
+  explicit DeadlineScope(std::chrono::milliseconds budget);
+
+  /**
+   * @brief Bound the requests by an existing deadline
+   * @param deadline point in time, Clock::time_point::max() for no limit
+   */
+  explicit DeadlineScope(Clock::time_point deadline);
+
+  /**
+   * @brief Restore the deadline of the enclosing scope
+   */
+  ~DeadlineScope();
+
+  /**
+   * @brief Deadline of the innermost scope of the calling thread
+   * @return Clock::time_point::max() outside of any scope
+   */
+  static Clock::time_point current();
+
+ private:
+  Clock::time_point previous;
+};
+
+/**
+ * @brief Sends one piece of a streamed request body
+ */
+typedef std::function<void(const char *data, size_t size)> BodyWriter;
+
+/**
+ * @brief Produces a streamed request body by calling the writer repeatedly
+ */
+typedef std::function<void(const BodyWriter &writer)> BodyProducer;
+
+/**
+ * @brief Pull style reader of a response body
+ *
+ * Transfer encoding is already removed, the reader yields the body bytes as
+ * they arrive on the connection
+ */
+class BodyReader {
+ public:
+  virtual ~BodyReader() {}
+
+  /**
+   * @brief Read the next part of the body
+   * @param buffer buffer the data to be written into
+   * @param size maximum size of data to be read
+   * @return size of data read, 0 once the whole body has been read
+   */
+  virtual size_t read(char *buffer, size_t size) = 0;
+
+  /**
+   * @brief Number of body bytes known to be left, 0 if unknown
+   */
+  virtual size_t sizeHint() const {
+    return 0;
+  }
+
+  /**
+   * @brief Read the rest of the body
+   *
+   * Data is read straight into the result, sized by sizeHint() when the
+   * length is known and grown geometrically otherwise
+   *
+   * @return the unread part of the body
+   */
+  string readAll();
+};
+
+/**
+ * @brief Splits a docker multiplexed body into stdout and stderr frames
+ *
+ * Each frame starts with an 8 byte header holding the stream type and the
+ * payload size. The payload is read straight from the body reader into the
+ * caller's buffer.
+ * https://docs.docker.com/engine/api/v1.24/#attach-to-a-container
+ */
+class StreamDemuxer {
+ public:
+  explicit StreamDemuxer(BodyReader &reader);
+
+  /**
+   * @brief Move to the next frame, skipping what is left of the current one
+   * @param type stream of the frame
+   * @param size payload size of the frame
+   * @return false once the body has no more frames
+   */
+  bool nextFrame(STREAM_TYPE &type, size_t &size);
+
+  /**
+   * @brief Read payload of the current frame
+   * @param buffer buffer the data to be written into
+   * @param size maximum size of data to be read
+   * @return size of data read, 0 at the end of the frame
+   */
+  size_t read(char *buffer, size_t size);
+
+ private:
+  BodyReader &reader;
+  size_t remaining;
+};
+
+/**
+ * @brief Receives demultiplexed output piece by piece as it arrives
+ *
+ * Returning false stops the transfer like BodySink
+ */
+typedef std::function<bool(STREAM_TYPE type, const char *data, size_t size)>
+    FrameSink;
+
+/**
+ * @brief Consumes a response body as it arrives
+ *
+ * Called once the status line and header are parsed. Body bytes the
+ * handler does not read are skipped afterwards
+ */
+typedef std::function<void(Response &response, BodyReader &body)>
+    ResponseHandler;
+
+/**
+ * @brief Receives a response body piece by piece as it arrives
+ *
+ * The next piece is not read from the connection until the sink returns.
+ * Returning false stops the transfer, the rest of the body is dropped
+ * together with the connection
+ */
+typedef std::function<bool(const char *data, size_t size)> BodySink;
+
+/**
+ * @brief Receives a response as soon as its status line and header are
+ *        parsed
+ */
+typedef std::function<void(const Response &response)> HeadCallback;
+
 /**
  * @brief Simple http client
  *
  * Contains some basic http request methods, with limited implementation.
  * Adapted to docker http request
  *
+ * The connection is kept alive between requests (HTTP/1.1 persistent
+ * connection) and transparently re-established when the daemon closes it.
+ * When a kept-alive connection fails under a request, GET, PUT and DELETE
+ * requests are sent again on a fresh one, a POST fails with SocketError
+ * since the daemon may already have run it
+ *
  */
 class SimpleHttpClient {
  public:
@@ -23,13 +218,175 @@ class SimpleHttpClient {
   ~SimpleHttpClient();
   shared_ptr<Response> Post(const Uri &uri, const Header &header,
                             const QueryParam &query_param, const string &data);
+
+  /**
+   * @brief Post with the body handed to a handler instead of being buffered
+   * @sa Get(const Uri &, const Header &, const QueryParam &,
+   *     const ResponseHandler &)
+   */
+  shared_ptr<Response> Post(const Uri &uri, const Header &header,
+                            const QueryParam &query_param, const string &data,
+                            const ResponseHandler &handler);
   shared_ptr<Response> Put(const Uri &uri, const Header &header,
                            const QueryParam &query_param, const string &data);
+  /**
+   * @brief Put a body of unknown length with chunked transfer encoding
+   *
+   * Every piece handed to the writer is sent as one chunk right away, so
+   * the body is never held in memory. The header must declare
+   * `Transfer-Encoding: chunked` instead of Content-Length. The producer
+   * may be called a second time if the request has to be resent on a fresh
+   * connection
+   *
+   * @param producer writes the body through the given writer
+   */
+  shared_ptr<Response> Put(const Uri &uri, const Header &header,
+                           const QueryParam &query_param,
+                           const BodyProducer &producer);
   shared_ptr<Response> Get(const Uri &uri, const Header &header,
                            const QueryParam &query_param);
+
+  /**
+   * @brief Get with the body handed to a handler instead of being buffered
+   *
+   * The returned response has an empty body unless the handler fills it
+   *
+   * @param handler reads the body from the connection
+   */
+  shared_ptr<Response> Get(const Uri &uri, const Header &header,
+                           const QueryParam &query_param,
+                           const ResponseHandler &handler);
   shared_ptr<Response> Delete(const Uri &uri, const Header &header,
                               const QueryParam &query_param);
 
+  /**
+   * @brief Send a request described by a Request object
+   * @param request request to be sent, its method selects Get, Post, Put or
+   *        Delete
+   */
+  shared_ptr<Response> Send(const Request &request);
+
+  /**
+   * @brief Send requests back to back on one keep-alive connection
+   *
+   * Up to 64 requests are written before their responses are read, so a
+   * burst of small requests costs a few round trips instead of one each.
+   * Requests the daemon did not answer before closing the connection are
+   * sent again once on a new connection if they are GET, PUT or DELETE,
+   * responses already received are kept. If a POST is among them the
+   * call fails with SocketError instead, since the daemon may already have
+   * run it. The total timeout bounds the whole call.
+   *
+   * @param requests requests to be sent, in order
+   * @return responses in the order of the requests
+   */
+  vector<shared_ptr<Response>> Pipeline(const vector<Request> &requests);
+
+  /**
+   * @brief Get with the body delivered to a sink instead of being buffered
+   *
+   * Works with Content-Length, chunked and docker raw-stream bodies, docker
+   * stream frame headers are removed before the data reaches the sink. The
+   * body of a non 2xx response is not streamed but kept in the returned
+   * response so the error can be reported
+   *
+   * @param sink receives the body as it arrives
+   * @param on_head called with the response once its head is parsed,
+   *        before any of the body, e.g. to learn that a stream is live
+   */
+  shared_ptr<Response> GetStream(const Uri &uri, const Header &header,
+                                 const QueryParam &query_param,
+                                 const BodySink &sink,
+                                 const HeadCallback &on_head = HeadCallback());
+
+  /**
+   * @brief Post with the body delivered to a sink instead of being buffered
+   * @sa GetStream()
+   */
+  shared_ptr<Response> PostStream(const Uri &uri, const Header &header,
+                                  const QueryParam &query_param,
+                                  const string &data, const BodySink &sink);
+
+  /**
+   * @brief Get a docker multiplexed body with stdout and stderr kept apart
+   *
+   * The response body must be multiplexed, i.e. the container or exec
+   * instance was created without Tty. The body of a non 2xx response is
+   * kept in the returned response
+   *
+   * @param sink receives each piece of output with its stream type
+   */
+  shared_ptr<Response> GetMultiplexed(const Uri &uri, const Header &header,
+                                      const QueryParam &query_param,
+                                      const FrameSink &sink);
+
+  /**
+   * @brief Post and receive a docker multiplexed body
+   * @sa GetMultiplexed()
+   */
+  shared_ptr<Response> PostMultiplexed(const Uri &uri, const Header &header,
+                                       const QueryParam &query_param,
+                                       const string &data,
+                                       const FrameSink &sink);
+
+  /**
+   * @brief Enable or disable connection reuse between requests
+   *
+   * Keep-alive is enabled by default. Disabling it closes the current
+   * connection, every following request opens and closes its own one
+   *
+   * @param keep_alive whether to keep the connection open
+   */
+  void setKeepAlive(bool keep_alive);
+
+  /**
+   * @brief Bound the following requests in time
+   *
+   * No limit is set by default. Streams that run as long as the caller
+   * wants, like followed logs, should not be given a total timeout
+   *
+   * @param timeouts limits applied to each request
+   * @sa DeadlineScope
+   */
+  void setTimeouts(const Timeouts &timeouts);
+
+  /**
+   * @brief Record requests and responses with their timings
+   *
+   * Takes effect from the next connection the client opens
+   *
+   * @param recorder recording to write to, nullptr to stop recording
+   * @sa Recorder
+   */
+  void setRecorder(const shared_ptr<Recorder> &recorder);
+
+  /**
+   * @brief Answer requests from a recording instead of the daemon
+   *
+   * The current connection is closed, the following ones are taken from
+   * the recording in the order they were recorded
+   *
+   * @param replayer recording to replay, nullptr to use the daemon again
+   * @sa Replayer
+   */
+  void setReplayer(const shared_ptr<Replayer> &replayer);
+
+  /**
+   * @brief Shut the current connection down for good
+   *
+   * The only method that may be called from another thread, it wakes up a
+   * request blocked on a long lived stream, which then ends or fails with
+   * SocketError. The client does not connect again afterwards, following
+   * requests fail with SocketError
+   */
+  void shutdown();
+
+  /**
+   * @brief Get counters of fresh and reused connections
+   * @return connection counters since the client was created
+   */
+  ConnectionStats getConnectionStats() const;
+
  private:
   class Impl;
   unique_ptr<Impl> m_impl;
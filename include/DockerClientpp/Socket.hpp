@@ -3,25 +3,57 @@
 
 #include "Archive.hpp"
 #include "Exceptions.hpp"
+#include "Recording.hpp"
+#include "StringRef.hpp"
 #include "defines.hpp"
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <chrono>
+
 namespace DockerClientpp {
+/**
+ * @brief Stream socket to the docker daemon
+ *
+ * Reads go through a per-connection read-ahead buffer, so bytes received
+ * past the end of a line stay available to the following read() or
+ * readLine() call, including the ones of the next response on a kept-alive
+ * connection
+ *
+ * The descriptor is non-blocking, every wait goes through poll() so it can
+ * be bounded by a deadline
+ */
 class Socket {
  public:
   Socket(const SOCK_TYPE type, const string &path);
   ~Socket();
 
+  /**
+   * @brief Build the address of the docker daemon
+   * @param type socket type that docker daemon use
+   * @param path path to the unix socket, or IP:Port for TCP
+   * @param addr address to be filled
+   * @return length of the filled address
+   */
+  static socklen_t makeAddress(const SOCK_TYPE type, const string &path,
+                               sockaddr_storage &addr);
+
+  typedef std::chrono::steady_clock Clock;
+
   /**
    * @brief Connect the socket
+   *
+   * Throws TimeoutError if the connection is not established before the
+   * deadline
    */
   void connect();
 
@@ -30,6 +62,25 @@ class Socket {
    */
   void close();
 
+  /**
+   * @brief Shut the connection down without closing the descriptor
+   *
+   * Safe to call from another thread, a read blocked on the socket returns
+   * end of file. The socket stays shut down, a later connect() fails with
+   * SocketError, so a shutdown between two connections is not lost
+   */
+  void shutdown();
+
+  /**
+   * @brief Check whether the socket can be reused for another request
+   *
+   * A connected socket is considered alive when the peer has not closed it
+   * and there is no unread data pending on it
+   *
+   * @return true if the socket is connected and idle
+   */
+  bool isAlive();
+
   /**
    * @brief Read data from socket
    * @param buffer buffer the data to be written into
@@ -37,6 +88,14 @@ class Socket {
    */
   void read(char *buffer, size_t size);
 
+  /**
+   * @brief Read the data available on socket, waiting only if there is none
+   * @param buffer buffer the data to be written into
+   * @param size maximum size of data to be read
+   * @return size of data read, 0 if the peer closed the connection
+   */
+  size_t readSome(char *buffer, size_t size);
+
   /**
    * @brief Read data from socket
    * @param size size of data to be read
@@ -66,6 +125,30 @@ class Socket {
    */
   const string &readLine(string &buffer);
 
+  /**
+   * @brief Bytes received but not consumed yet
+   *
+   * Lets a parser work in place on the read-ahead buffer, the slice is
+   * valid until the next read, receiveMore() or consume() call
+   */
+  StringRef buffered() const;
+
+  /**
+   * @brief Receive more data after the buffered bytes, keeping them
+   *
+   * The buffer grows when it is full, so a parser can wait for a line or
+   * a head larger than what one read returns
+   *
+   * @return size of data received, 0 if the peer closed the connection
+   */
+  size_t receiveMore();
+
+  /**
+   * @brief Mark the first buffered bytes as consumed
+   * @param size number of bytes, at most buffered().size
+   */
+  void consume(size_t size);
+
   /**
    * @brief Write data to socket
    * @param content content to be sent
@@ -79,12 +162,48 @@ class Socket {
    */
   void write(const string &content);
 
+  /**
+   * @brief Write several buffers to socket in one gathered write
+   *
+   * The buffers are sent in order without being copied together first
+   *
+   * @param iov buffers to be sent
+   * @param count number of buffers
+   */
+  void write(const iovec *iov, int count);
+
   /**
    * @brief Write archive to socket
    * @param archive archive to be sent
    */
   void write(Utility::Archive &archive);
 
+  /**
+   * @brief Bound the following connect, read and write calls
+   *
+   * A call still waiting for the daemon at the deadline throws
+   * TimeoutError, the connection is then in an unknown state and should be
+   * closed. Replayed connections ignore the deadline
+   *
+   * @param deadline point in time, Clock::time_point::max() for no limit
+   */
+  void setDeadline(Clock::time_point deadline);
+
+  /**
+   * @brief Record the traffic of the following connections
+   * @param recorder recording to write to, nullptr to stop recording
+   */
+  void setRecorder(const shared_ptr<Recorder> &recorder);
+
+  /**
+   * @brief Serve the following connections from a recording
+   *
+   * No connection to the daemon is made while a replayer is set
+   *
+   * @param replayer recording to replay, nullptr to use the daemon again
+   */
+  void setReplayer(const shared_ptr<Replayer> &replayer);
+
  private:
   class Impl;
   unique_ptr<Impl> m_impl;
@@ -0,0 +1,39 @@
+#ifndef DOCKER_CLIENT_PP_STRINGREF_H
+#define DOCKER_CLIENT_PP_STRINGREF_H
+
+#include "defines.hpp"
+
+#include <cstring>
+
+namespace DockerClientpp {
+
+/**
+ * @brief Non-owning slice of a character buffer
+ *
+ * Stands in for std::string_view, which is not available in C++14. It is
+ * only valid as long as the buffer it points into
+ */
+struct StringRef {
+  const char *data = nullptr;  ///<  First character of the slice
+  size_t size = 0;             ///<  Number of characters
+
+  StringRef() = default;
+  StringRef(const char *data, size_t size) : data(data), size(size) {}
+
+  bool empty() const {
+    return size == 0;
+  }
+  string str() const {
+    return string(data, size);
+  }
+  bool operator==(const char *other) const {
+    return strlen(other) == size && memcmp(data, other, size) == 0;
+  }
+  bool operator!=(const char *other) const {
+    return !(*this == other);
+  }
+};
+
+}  // namespace  DockerClientpp
+
+#endif /* DOCKER_CLIENT_PP_STRINGREF_H */
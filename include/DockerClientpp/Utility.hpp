@@ -5,6 +5,8 @@
 #include "Response.hpp"
 #include "defines.hpp"
 
+#include <cstdint>
+#include <functional>
 #include <sstream>
 
 namespace DockerClientpp {
@@ -35,6 +37,131 @@ Header loadHeader(const string &header_str);
  * @return Dumped header string
  */
 string dumpHeader(const Header &header);
+
+/**
+ * @brief Build the query string of a request uri
+ *
+ * @param query_param query parameters
+ *
+ * @return "?key=value&..." or an empty string if there is no parameter
+ */
+string buildQuery(const QueryParam &query_param);
+
+/**
+ * @brief Percent-encode a string for use in a query parameter
+ *
+ * Everything but unreserved characters (RFC 3986) is encoded
+ *
+ * @param value raw value
+ *
+ * @return encoded value
+ */
+string percentEncode(const string &value);
+
+/**
+ * @brief Pull style JSON reader working in place on a buffer
+ *
+ * Values are read one at a time in document order and anything not asked
+ * for is skipped without being decoded, so no DOM is built. Malformed
+ * input throws ParseError.
+ *
+ * @code
+ * JsonScanner scanner(body.data(), body.data() + body.size());
+ * scanner.beginObject();
+ * string key;
+ * while (scanner.nextMember(key)) {
+ *   if (key == "Id") id = scanner.readString();
+ *   else scanner.skipValue();
+ * }
+ * @endcode
+ */
+class JsonScanner {
+ public:
+  JsonScanner(const char *begin, const char *end);
+
+  /**
+   * @brief Type of the next value: '{', '[', '"', 'n'umber, 't'rue,
+   *        'f'alse, 'N'ull, or 0 at the end of input
+   */
+  char peek();
+
+  /**
+   * @brief Enter the object that is the next value
+   */
+  void beginObject();
+  /**
+   * @brief Read the key of the next member of the current object
+   * @return false, after leaving the object, if there is no more member
+   */
+  bool nextMember(string &key);
+  /**
+   * @brief Enter the array that is the next value
+   */
+  void beginArray();
+  /**
+   * @brief Move to the next element of the current array
+   * @return false, after leaving the array, if there is no more element
+   */
+  bool nextElement();
+
+  string readString();
+  int64_t readInteger();
+  uint64_t readUnsigned();
+  double readDouble();
+  bool readBool();
+  /**
+   * @brief Consume the next value if it is null
+   * @return whether it was null
+   */
+  bool readNull();
+  /**
+   * @brief Skip the next value, whatever its type
+   */
+  void skipValue();
+
+ private:
+  void skipSpace();
+  void expect(char c);
+  void skipString();
+  bool readNumber(char *buffer, size_t size);
+  const char *numberEnd();
+  [[noreturn]] void fail(const string &what);
+
+  const char *begin;
+  const char *pos;
+  const char *end;
+  //  Whether an element or member was already read at each nesting level
+  vector<bool> started;
+};
+
+/**
+ * @brief Incremental decoder of newline delimited JSON streams
+ *
+ * Bytes can be fed in pieces of any size, each complete line is parsed as
+ * soon as its newline arrives and only an unfinished line is kept
+ */
+class JsonLineDecoder {
+ public:
+  /**
+   * @brief Receives each decoded value, return false to stop decoding
+   */
+  typedef std::function<bool(const json &value)> Callback;
+
+  /**
+   * @brief Decode the lines completed by the given data
+   * @param data next piece of the stream
+   * @param size size of the data
+   * @param callback called with each decoded value
+   * @return false if the callback asked to stop
+   */
+  bool feed(const char *data, size_t size, const Callback &callback);
+
+ private:
+  static bool decode(const char *begin, const char *end,
+                     const Callback &callback);
+
+  string pending;
+};
 }  // namespace Utility
 }  // namespace DockerClientpp
 
@@ -36,6 +36,11 @@ using is_base_of_template =
  */
 enum SOCK_TYPE { SOCK_UNIX, SOCK_TCP };
 
+/**
+ * @brief Stream a frame of docker multiplexed output belongs to
+ */
+enum STREAM_TYPE { STREAM_STDIN = 0, STREAM_STDOUT = 1, STREAM_STDERR = 2 };
+
 using nlohmann::json;
 using std::string;
 using std::vector;
@@ -44,7 +49,6 @@ using std::unique_ptr;
 
 namespace Http {
 typedef std::string Uri;
-typedef json Header;
 typedef std::map<std::string, std::string> QueryParam;
 }  // namespace Http
 }
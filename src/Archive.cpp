@@ -1,4 +1,5 @@
 #include "Archive.hpp"
+#include "Exceptions.hpp"
 
 #include "archive.h"
 #include "archive_entry.h"
@@ -6,6 +7,8 @@
 #include <dirent.h>
 #include <fcntl.h>
 
+#include <exception>
+
 namespace DockerClientpp {
 namespace Utility {
 class Archive::Impl {
@@ -15,14 +18,23 @@ class Archive::Impl {
   void addFile(const string &file);
   void addFiles(const vector<string> &files);
   void writeToFd(const int fd);
+  void writeTo(const Writer &writer);
   string getTar();
   static void extractTar(const string &tar_buffer, const string &path);
+  static void extractTar(const Reader &reader, const string &path);
 
  private:
+  static int extractEntries(archive *a, const string &path);
+  static string errorString(archive *a);
+  void writeEntries(archive *a);
   void writeEntry(archive *a, const string &file_name, const string &file_path);
 
   static la_ssize_t writeToBuffer(archive *a, void *client_data,
                                   const void *buff, size_t n);
+  static la_ssize_t writeToWriter(archive *a, void *client_data,
+                                  const void *buff, size_t n);
+  static la_ssize_t readFromReader(archive *a, void *client_data,
+                                   const void **buff);
   static int writeContentToDisk(archive *a, archive *disk);
 
   vector<string> m_files;
@@ -31,6 +43,9 @@ class Archive::Impl {
 }  // namespace DockerClientpp
 
 using namespace DockerClientpp::Utility;
+using DockerClientpp::ParseError;
+
+const size_t READ_BLOCK_SIZE = 64 * 1024;
 
 Archive::Impl::Impl() {}
 
@@ -51,19 +66,35 @@ void Archive::Impl::writeToFd(const int fd) {
   archive_write_set_format_pax_restricted(a);
 
   archive_write_open_fd(a, fd);
-  for (const auto &file : m_files) {
-    string file_name;
-    auto pos = file.find_last_of('/');
-    if (pos != std::string::npos) {
-      file_name = file.substr(pos + 1);
-    } else {
-      file_name = file;
-    }
-    writeEntry(a, file_name, file);
-  }
+  writeEntries(a);
   archive_write_free(a);
 }
 
+namespace {
+struct WriterContext {
+  const Archive::Writer *writer;
+  std::exception_ptr error;
+};
+}  // namespace
+
+void Archive::Impl::writeTo(const Writer &writer) {
+  archive *a;
+  WriterContext context{&writer, nullptr};
+
+  a = archive_write_new();
+
+  archive_write_set_format_pax_restricted(a);
+  //  Do not pad the stream up to a full block
+  archive_write_set_bytes_in_last_block(a, 1);
+
+  archive_write_open(a, &context, nullptr, writeToWriter, nullptr);
+  writeEntries(a);
+  archive_write_free(a);
+  if (context.error) {
+    std::rethrow_exception(context.error);
+  }
+}
+
 DockerClientpp::string Archive::Impl::getTar() {
   archive *a;
   string buffer;
@@ -73,6 +104,12 @@ DockerClientpp::string Archive::Impl::getTar() {
   archive_write_set_format_pax_restricted(a);
 
   archive_write_open(a, &buffer, nullptr, writeToBuffer, nullptr);
+  writeEntries(a);
+  archive_write_free(a);
+  return buffer;
+}
+
+void Archive::Impl::writeEntries(archive *a) {
   for (const auto &file : m_files) {
     string file_name;
     auto pos = file.find_last_of('/');
@@ -83,8 +120,6 @@ DockerClientpp::string Archive::Impl::getTar() {
     }
     writeEntry(a, file_name, file);
   }
-  archive_write_free(a);
-  return buffer;
 }
 
 void Archive::Impl::writeEntry(archive *a,
@@ -134,36 +169,110 @@ la_ssize_t Archive::Impl::writeToBuffer(archive *, void *client_data,
   return n;
 }
 
+la_ssize_t Archive::Impl::writeToWriter(archive *a, void *client_data,
+                                        const void *buff, size_t n) {
+  //  Exceptions must not unwind through libarchive, keep it for later
+  WriterContext *context = reinterpret_cast<WriterContext *>(client_data);
+  if (context->error) return -1;
+  try {
+    (*context->writer)(reinterpret_cast<const char *>(buff), n);
+  } catch (...) {
+    context->error = std::current_exception();
+    archive_set_error(a, EIO, "archive writer failed");
+    return -1;
+  }
+  return n;
+}
+
 void Archive::Impl::extractTar(const string &tar_buffer, const string &path) {
   archive *a;
+  a = archive_read_new();
+  archive_read_support_format_all(a);
+  // archive_read_support_compression_all(a);
+
+  archive_read_open_memory(a, tar_buffer.c_str(), tar_buffer.size());
+  int ret = extractEntries(a, path);
+  string error = ret < ARCHIVE_WARN ? errorString(a) : string();
+  archive_read_close(a);
+  archive_read_free(a);
+  if (!error.empty()) {
+    throw ParseError("Extract archive error: " + error);
+  }
+}
+
+namespace {
+struct ReaderContext {
+  const Archive::Reader *reader;
+  std::exception_ptr error;
+  std::vector<char> buffer;
+};
+}  // namespace
+
+void Archive::Impl::extractTar(const Reader &reader, const string &path) {
+  archive *a;
+  ReaderContext context{&reader, nullptr, std::vector<char>(READ_BLOCK_SIZE)};
+  a = archive_read_new();
+  archive_read_support_format_all(a);
+
+  archive_read_open(a, &context, nullptr, readFromReader, nullptr);
+  int ret = extractEntries(a, path);
+  string error = ret < ARCHIVE_WARN ? errorString(a) : string();
+  archive_read_close(a);
+  archive_read_free(a);
+  if (context.error) {
+    std::rethrow_exception(context.error);
+  }
+  if (!error.empty()) {
+    throw ParseError("Extract archive error: " + error);
+  }
+}
+
+int Archive::Impl::extractEntries(archive *a, const string &path) {
   archive *ext;
   archive_entry *entry;
   int flags = ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM |
               ARCHIVE_EXTRACT_ACL | ARCHIVE_EXTRACT_FFLAGS;
   int ret;
-  a = archive_read_new();
-  archive_read_support_format_all(a);
-  // archive_read_support_compression_all(a);
   ext = archive_write_disk_new();
   archive_write_disk_set_options(ext, flags);
   archive_write_disk_set_standard_lookup(ext);
 
-  archive_read_open_memory(a, tar_buffer.c_str(), tar_buffer.size());
   for (;;) {
     ret = archive_read_next_header(a, &entry);
     if (ret == ARCHIVE_EOF) break;
+    if (ret < ARCHIVE_WARN) break;
     archive_entry_set_pathname(
         entry, (path + "/" + archive_entry_pathname(entry)).c_str());
     archive_write_header(ext, entry);
     if (archive_entry_size(entry) > 0) {
-      writeContentToDisk(a, ext);
+      ret = writeContentToDisk(a, ext);
     }
     archive_write_finish_entry(ext);
+    if (ret < ARCHIVE_WARN) break;
   }
-  archive_read_close(a);
-  archive_read_free(a);
   archive_write_close(ext);
   archive_write_free(ext);
+  return ret;
+}
+
+la_ssize_t Archive::Impl::readFromReader(archive *a, void *client_data,
+                                         const void **buff) {
+  //  Exceptions must not unwind through libarchive, keep it for later
+  ReaderContext *context = reinterpret_cast<ReaderContext *>(client_data);
+  if (context->error) return -1;
+  try {
+    *buff = context->buffer.data();
+    return (*context->reader)(context->buffer.data(), context->buffer.size());
+  } catch (...) {
+    context->error = std::current_exception();
+    archive_set_error(a, EIO, "archive reader failed");
+    return -1;
+  }
+}
+
+string Archive::Impl::errorString(archive *a) {
+  const char *error = archive_error_string(a);
+  return error ? error : "unknown error";
 }
 
 int Archive::Impl::writeContentToDisk(archive *a, archive *disk) {
@@ -176,6 +285,9 @@ int Archive::Impl::writeContentToDisk(archive *a, archive *disk) {
     if (ret == ARCHIVE_EOF) {
       return ARCHIVE_OK;
     }
+    if (ret < ARCHIVE_WARN) {
+      return ret;
+    }
     archive_write_data_block(disk, buff, size, offset);
   }
 }
@@ -190,6 +302,10 @@ void Archive::writeToFd(const int fd) {
   m_impl->writeToFd(fd);
 }
 
+void Archive::writeTo(const Writer &writer) {
+  m_impl->writeTo(writer);
+}
+
 DockerClientpp::string Archive::getTar() {
   return m_impl->getTar();
 }
@@ -205,3 +321,7 @@ void Archive::addFiles(const vector<string> &files) {
 void Archive::extractTar(const string &tar_buffer, const string &path) {
   Impl::extractTar(tar_buffer, path);
 }
+
+void Archive::extractTar(const Reader &reader, const string &path) {
+  Impl::extractTar(reader, path);
+}
@@ -0,0 +1,175 @@
+#include "AsyncDockerClient.hpp"
+#include "Operations.hpp"
+
+namespace DockerClientpp {
+class AsyncDockerClient::Impl {
+ public:
+  Impl(const SOCK_TYPE type, const string &path, size_t max_connections);
+  ~Impl();
+  void setAPIVersion(const string &api);
+  Http::ConnectionStats getConnectionStats() const;
+
+  template <class Operation, class... Args>
+  std::future<typename Operation::Result> call(Args &&... args);
+
+ private:
+  template <class T, class F>
+  static void settle(std::promise<T> &promise, const F &result) {
+    promise.set_value(result());
+  }
+  template <class F>
+  static void settle(std::promise<void> &promise, const F &result) {
+    result();
+    promise.set_value();
+  }
+
+  Http::AsyncHttpClient client;
+  string api_version;
+};
+}  // namespace DockerClientpp
+
+using namespace DockerClientpp;
+using namespace Http;
+
+AsyncDockerClient::Impl::Impl(const SOCK_TYPE type, const string &path,
+                              size_t max_connections)
+    : client(type, path, max_connections), api_version("v1.24") {}
+
+AsyncDockerClient::Impl::~Impl() {}
+
+void AsyncDockerClient::Impl::setAPIVersion(const string &api) {
+  api_version = api;
+}
+
+ConnectionStats AsyncDockerClient::Impl::getConnectionStats() const {
+  return client.getConnectionStats();
+}
+
+template <class Operation, class... Args>
+std::future<typename Operation::Result> AsyncDockerClient::Impl::call(
+    Args &&... args) {
+  typedef typename Operation::Result Result;
+  //  Shared with the completion callback, which runs on the loop thread
+  auto request = std::make_shared<Request>(
+      Operation::request(std::forward<Args>(args)...));
+  Operations::prepare(*request, api_version);
+  auto promise = std::make_shared<std::promise<Result>>();
+  std::future<Result> future = promise->get_future();
+  client.send(*request, [request, promise](shared_ptr<Response> response,
+                                           std::exception_ptr error) {
+    if (error) {
+      promise->set_exception(error);
+      return;
+    }
+    try {
+      settle(*promise,
+             [&] { return Operation::result(*request, *response); });
+    } catch (...) {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return future;
+}
+
+//-------------------------AsyncDockerClient Implementation-------------------------//
+
+AsyncDockerClient::AsyncDockerClient(const SOCK_TYPE type, const string &path,
+                                     size_t max_connections)
+    : m_impl(new Impl(type, path, max_connections)) {}
+
+AsyncDockerClient::~AsyncDockerClient() {}
+
+void AsyncDockerClient::setAPIVersion(const string &api) {
+  m_impl->setAPIVersion(api);
+}
+
+std::future<vector<string>> AsyncDockerClient::listImages() {
+  return m_impl->call<Operations::ListImages>();
+}
+
+std::future<vector<string>> AsyncDockerClient::getRunningContainers() {
+  return m_impl->call<Operations::GetRunningContainers>();
+}
+
+std::future<string> AsyncDockerClient::createContainer(const json &config,
+                                                       const string &name) {
+  return m_impl->call<Operations::CreateContainer>(config, name);
+}
+
+std::future<void> AsyncDockerClient::startContainer(const string &identifier) {
+  return m_impl->call<Operations::StartContainer>(identifier);
+}
+
+std::future<void> AsyncDockerClient::stopContainer(const string &identifier) {
+  return m_impl->call<Operations::StopContainer>(identifier);
+}
+
+std::future<void> AsyncDockerClient::killContainer(const string &identifier) {
+  return m_impl->call<Operations::KillContainer>(identifier);
+}
+
+std::future<void> AsyncDockerClient::removeContainer(const string &identifier,
+                                                     bool remove_volume,
+                                                     bool force,
+                                                     bool remove_link) {
+  return m_impl->call<Operations::RemoveContainer>(identifier, remove_volume,
+                                                   force, remove_link);
+}
+
+std::future<int> AsyncDockerClient::waitContainer(const string &identifier,
+                                                  const string &condition) {
+  return m_impl->call<Operations::WaitContainer>(identifier, condition);
+}
+
+std::future<string> AsyncDockerClient::inspectContainer(
+    const string &identifier) {
+  return m_impl->call<Operations::InspectContainer>(identifier);
+}
+
+std::future<ContainerInfo> AsyncDockerClient::inspectContainerInfo(
+    const string &identifier) {
+  return m_impl->call<Operations::InspectContainerInfo>(identifier);
+}
+
+std::future<string> AsyncDockerClient::getLongId(const string &name) {
+  return m_impl->call<Operations::GetLongId>(name);
+}
+
+std::future<void> AsyncDockerClient::updateContainer(const string &identifier,
+                                                     const json &config) {
+  return m_impl->call<Operations::UpdateContainer>(identifier, config);
+}
+
+std::future<string> AsyncDockerClient::getContainerStats(
+    const string &identifier) {
+  return m_impl->call<Operations::GetContainerStats>(identifier);
+}
+
+std::future<StatsSample> AsyncDockerClient::getContainerStatsSample(
+    const string &identifier) {
+  return m_impl->call<Operations::GetContainerStatsSample>(identifier);
+}
+
+std::future<string> AsyncDockerClient::getLogs(const string &identifier,
+                                               bool std_out, bool std_err,
+                                               int tail) {
+  return m_impl->call<Operations::GetLogs>(identifier, std_out, std_err, tail);
+}
+
+std::future<string> AsyncDockerClient::createExecution(
+    const string &identifier, const json &config) {
+  return m_impl->call<Operations::CreateExecution>(identifier, config);
+}
+
+std::future<string> AsyncDockerClient::inspectExecution(const string &id) {
+  return m_impl->call<Operations::InspectExecution>(id);
+}
+
+std::future<ExecInfo> AsyncDockerClient::inspectExecutionInfo(
+    const string &id) {
+  return m_impl->call<Operations::InspectExecutionInfo>(id);
+}
+
+ConnectionStats AsyncDockerClient::getConnectionStats() const {
+  return m_impl->getConnectionStats();
+}
@@ -0,0 +1,618 @@
+#include "AsyncHttpClient.hpp"
+#include "ResponseParser.hpp"
+#include "Socket.hpp"
+#include "Utility.hpp"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace DockerClientpp {
+namespace Http {
+namespace {
+/**
+ * @brief Incremental parser of one http response
+ *
+ * Bytes are fed as they arrive from a non-blocking socket, parsing
+ * resumes where the previous call stopped
+ */
+class ResponseAssembler {
+ public:
+  void reset();
+  /**
+   * @brief Consume bytes from the input
+   * @return true when the response is complete
+   */
+  bool feed(string &input);
+  /**
+   * @brief Peer closed the connection
+   * @return true if that ends the response instead of truncating it
+   */
+  bool finishOnEof();
+  /**
+   * @brief Whether the connection can carry the next request
+   */
+  bool reusable() const {
+    return keep_alive && state == DONE;
+  }
+
+  shared_ptr<Response> response;
+
+ private:
+  enum State {
+    HEADER,
+    BODY_LENGTH,
+    CHUNK_SIZE,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    TRAILER,
+    BODY_EOF,
+    DONE
+  };
+
+  bool parseHeader(const string &input, size_t &pos);
+  static bool nextLine(const string &input, size_t &pos, size_t &line_size);
+
+  ResponseParser parser;
+  State state;
+  size_t remaining;
+  bool keep_alive;
+};
+
+struct Exchange {
+  string data;
+  Uri uri;
+  AsyncHttpClient::CompletionCallback callback;
+  bool retried;
+  //  Whether running the request twice does no harm
+  bool idempotent;
+};
+
+struct Connection {
+  int fd;
+  bool connected;
+  bool reused;
+  bool received;
+  unique_ptr<Exchange> exchange;
+  size_t written;
+  string input;
+  ResponseAssembler assembler;
+};
+}  // namespace
+
+class AsyncHttpClient::Impl {
+ public:
+  Impl(const SOCK_TYPE type, const string &path, size_t max_connections);
+  ~Impl();
+  void send(const Request &request, const CompletionCallback &callback);
+  ConnectionStats getConnectionStats() const;
+
+ private:
+  void run();
+  void takeSubmissions();
+  void dispatch();
+  //  nullptr while the daemon's backlog is full
+  Connection *openConnection();
+  void assign(Connection *connection, unique_ptr<Exchange> exchange);
+  void handle(Connection *connection, uint32_t events);
+  void writeSome(Connection *connection);
+  void readSome(Connection *connection);
+  void complete(Connection *connection);
+  void fail(Connection *connection, const string &what);
+  void closeConnection(Connection *connection);
+  void watch(Connection *connection, uint32_t events);
+  void shutdown();
+  static void finish(const Exchange &exchange, shared_ptr<Response> response,
+                     std::exception_ptr error);
+
+  sockaddr_storage addr;
+  socklen_t addr_length;
+  const size_t max_connections;
+
+  int epoll_fd;
+  int wakeup_fd;
+  std::thread loop;
+  std::atomic<bool> stopping;
+
+  //  Handed over from send() to the loop thread
+  std::mutex submission_mutex;
+  std::deque<unique_ptr<Exchange>> submitted;
+
+  //  Owned by the loop thread
+  std::deque<unique_ptr<Exchange>> waiting;
+  vector<unique_ptr<Connection>> connections;
+  vector<Connection *> idle;
+  //  Closed during the current batch of events, freed after it
+  vector<unique_ptr<Connection>> closed;
+  //  Backoff before connecting again while the daemon's backlog is full,
+  //  0 when no connect is pending
+  int connect_retry_ms;
+
+  std::atomic<size_t> fresh;
+  std::atomic<size_t> reused;
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+using namespace DockerClientpp;
+using namespace DockerClientpp::Http;
+
+const size_t MAX_EVENTS = 64;
+const size_t RECV_BLOCK_SIZE = 16 * 1024;
+
+void ResponseAssembler::reset() {
+  response = std::make_shared<Response>();
+  parser.reset();
+  state = HEADER;
+  remaining = 0;
+  keep_alive = true;
+}
+
+bool ResponseAssembler::nextLine(const string &input, size_t &pos,
+                                 size_t &line_size) {
+  line_size = ResponseParser::lineSize(input.data() + pos, input.size() - pos);
+  return line_size != 0;
+}
+
+bool ResponseAssembler::parseHeader(const string &input, size_t &pos) {
+  //  The head stays at the front of input until it is complete, lines
+  //  parsed by earlier calls are not scanned again
+  if (!parser.parseHead(input.data() + pos, input.size() - pos)) {
+    return false;
+  }
+  parser.fillResponse(*response);
+  pos += parser.headSize();
+  keep_alive = parser.keepAlive();
+  switch (parser.bodyMode()) {
+    case ResponseParser::NO_BODY:
+      state = DONE;
+      break;
+    case ResponseParser::CHUNKED:
+      state = CHUNK_SIZE;
+      break;
+    case ResponseParser::CONTENT_LENGTH:
+      remaining = parser.contentLength();
+      response->body.reserve(remaining);
+      state = remaining == 0 ? DONE : BODY_LENGTH;
+      break;
+    case ResponseParser::UNTIL_EOF:
+      state = BODY_EOF;
+      break;
+  }
+  return true;
+}
+
+bool ResponseAssembler::feed(string &input) {
+  size_t pos = 0;
+  size_t line_size;
+  bool progress = true;
+  while (progress && state != DONE) {
+    progress = false;
+    switch (state) {
+      case HEADER:
+        progress = parseHeader(input, pos);
+        break;
+      case BODY_LENGTH:
+      case CHUNK_DATA: {
+        size_t size = std::min(remaining, input.size() - pos);
+        response->body.append(input, pos, size);
+        pos += size;
+        remaining -= size;
+        if (remaining == 0) {
+          state = state == BODY_LENGTH ? DONE : CHUNK_DATA_END;
+          progress = true;
+        }
+        break;
+      }
+      case CHUNK_DATA_END:
+        if (input.size() - pos >= 2) {
+          pos += 2;
+          state = CHUNK_SIZE;
+          progress = true;
+        }
+        break;
+      case CHUNK_SIZE:
+        if (nextLine(input, pos, line_size)) {
+          remaining = ResponseParser::parseChunkSize(
+              StringRef(input.data() + pos, line_size - 2));
+          pos += line_size;
+          state = remaining == 0 ? TRAILER : CHUNK_DATA;
+          progress = true;
+        }
+        break;
+      case TRAILER:
+        //  Skip trailer fields up to the empty line
+        if (nextLine(input, pos, line_size)) {
+          state = line_size == 2 ? DONE : TRAILER;
+          pos += line_size;
+          progress = true;
+        }
+        break;
+      case BODY_EOF:
+        response->body.append(input, pos, string::npos);
+        pos = input.size();
+        break;
+      case DONE:
+        break;
+    }
+  }
+  input.erase(0, pos);
+  return state == DONE;
+}
+
+bool ResponseAssembler::finishOnEof() {
+  if (state != BODY_EOF) return false;
+  state = DONE;
+  return true;
+}
+
+AsyncHttpClient::Impl::Impl(const SOCK_TYPE type, const string &path,
+                            size_t max_connections)
+    : max_connections(max_connections),
+      epoll_fd(-1),
+      wakeup_fd(-1),
+      stopping(false),
+      connect_retry_ms(0),
+      fresh(0),
+      reused(0) {
+  if (max_connections == 0) {
+    throw Exception("AsyncHttpClient max_connections must be positive");
+  }
+  addr_length = Socket::makeAddress(type, path, addr);
+  if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    throw SocketError(strerror(errno));
+  }
+  if ((wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+    ::close(epoll_fd);
+    throw SocketError(strerror(errno));
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event);
+  loop = std::thread([this] { run(); });
+}
+
+AsyncHttpClient::Impl::~Impl() {
+  stopping = true;
+  uint64_t one = 1;
+  ssize_t written = ::write(wakeup_fd, &one, sizeof(one));
+  (void)written;
+  loop.join();
+  ::close(wakeup_fd);
+  ::close(epoll_fd);
+}
+
+void AsyncHttpClient::Impl::send(const Request &request,
+                                 const CompletionCallback &callback) {
+  unique_ptr<Exchange> exchange(new Exchange{
+      string(), string(), callback, false,
+      request.method == "GET" || request.method == "HEAD" ||
+          request.method == "PUT" || request.method == "DELETE"});
+  exchange->uri = request.uri + Utility::buildQuery(request.query_param);
+  exchange->data = request.method + " " + exchange->uri + " HTTP/1.1\r\n";
+  exchange->data += Utility::dumpHeader(request.header);
+  exchange->data += request.body;
+  {
+    std::lock_guard<std::mutex> lock(submission_mutex);
+    submitted.push_back(std::move(exchange));
+  }
+  uint64_t one = 1;
+  ssize_t written = ::write(wakeup_fd, &one, sizeof(one));
+  (void)written;
+}
+
+ConnectionStats AsyncHttpClient::Impl::getConnectionStats() const {
+  ConnectionStats stats;
+  stats.fresh = fresh;
+  stats.reused = reused;
+  return stats;
+}
+
+void AsyncHttpClient::Impl::run() {
+  epoll_event events[MAX_EVENTS];
+  while (!stopping) {
+    //  Wakes up on its own when a connect has to be tried again
+    int count = epoll_wait(epoll_fd, events, MAX_EVENTS,
+                           connect_retry_ms > 0 ? connect_retry_ms : -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    for (int i = 0; i < count; i++) {
+      if (events[i].data.ptr == nullptr) {
+        uint64_t value;
+        ssize_t read_d = ::read(wakeup_fd, &value, sizeof(value));
+        (void)read_d;
+        continue;
+      }
+      Connection *connection =
+          reinterpret_cast<Connection *>(events[i].data.ptr);
+      //  Connections closed earlier in this batch are skipped
+      if (connection->fd >= 0) handle(connection, events[i].events);
+    }
+    closed.clear();
+    takeSubmissions();
+    dispatch();
+  }
+  shutdown();
+}
+
+void AsyncHttpClient::Impl::takeSubmissions() {
+  std::lock_guard<std::mutex> lock(submission_mutex);
+  while (!submitted.empty()) {
+    waiting.push_back(std::move(submitted.front()));
+    submitted.pop_front();
+  }
+}
+
+void AsyncHttpClient::Impl::dispatch() {
+  while (!waiting.empty()) {
+    Connection *connection;
+    if (!idle.empty()) {
+      //  Most recently used connection first
+      connection = idle.back();
+      idle.pop_back();
+      connection->reused = true;
+      reused++;
+    } else if (connections.size() < max_connections) {
+      try {
+        connection = openConnection();
+      } catch (const SocketError &) {
+        unique_ptr<Exchange> exchange = std::move(waiting.front());
+        waiting.pop_front();
+        finish(*exchange, nullptr, std::current_exception());
+        continue;
+      }
+      if (connection == nullptr) {
+        //  The exchange keeps its place, the next loop pass tries again
+        connect_retry_ms =
+            connect_retry_ms == 0 ? 1 : std::min(connect_retry_ms * 2, 100);
+        break;
+      }
+      connect_retry_ms = 0;
+      fresh++;
+    } else {
+      break;
+    }
+    unique_ptr<Exchange> exchange = std::move(waiting.front());
+    waiting.pop_front();
+    assign(connection, std::move(exchange));
+  }
+}
+
+Connection *AsyncHttpClient::Impl::openConnection() {
+  sockaddr *addr_ptr = reinterpret_cast<sockaddr *>(&addr);
+  int fd = socket(addr_ptr->sa_family,
+                  SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    throw SocketError(strerror(errno));
+  }
+  bool connected = true;
+  if (::connect(fd, addr_ptr, addr_length) < 0) {
+    if (errno == EAGAIN) {
+      //  Backlog of a unix socket is full, nothing to wait for on the fd
+      ::close(fd);
+      return nullptr;
+    }
+    if (errno != EINPROGRESS) {
+      int error = errno;
+      ::close(fd);
+      throw SocketError(strerror(error));
+    }
+    connected = false;
+  }
+  unique_ptr<Connection> connection(
+      new Connection{fd, connected, false, false, nullptr, 0, string(),
+                     ResponseAssembler()});
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLOUT;
+  event.data.ptr = connection.get();
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+  connections.push_back(std::move(connection));
+  return connections.back().get();
+}
+
+void AsyncHttpClient::Impl::assign(Connection *connection,
+                                   unique_ptr<Exchange> exchange) {
+  connection->exchange = std::move(exchange);
+  connection->written = 0;
+  connection->received = false;
+  connection->input.clear();
+  connection->assembler.reset();
+  if (connection->connected) {
+    writeSome(connection);
+  }
+}
+
+void AsyncHttpClient::Impl::handle(Connection *connection, uint32_t events) {
+  if (!connection->connected) {
+    if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(connection->fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    if (error != 0) {
+      fail(connection, strerror(error));
+      return;
+    }
+    connection->connected = true;
+    if (connection->exchange) writeSome(connection);
+    return;
+  }
+  if (events & EPOLLOUT) {
+    writeSome(connection);
+    if (connection->fd < 0) return;
+  }
+  if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+    readSome(connection);
+  }
+}
+
+void AsyncHttpClient::Impl::writeSome(Connection *connection) {
+  if (!connection->exchange) return;
+  const string &data = connection->exchange->data;
+  while (connection->written < data.size()) {
+    ssize_t sent =
+        ::send(connection->fd, data.data() + connection->written,
+               data.size() - connection->written, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        watch(connection, EPOLLIN | EPOLLOUT);
+        return;
+      }
+      fail(connection, strerror(errno));
+      return;
+    }
+    connection->written += sent;
+  }
+  watch(connection, EPOLLIN);
+}
+
+void AsyncHttpClient::Impl::readSome(Connection *connection) {
+  char buffer[RECV_BLOCK_SIZE];
+  while (true) {
+    ssize_t read_d = ::recv(connection->fd, buffer, sizeof(buffer), 0);
+    if (read_d < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+      fail(connection, strerror(errno));
+      return;
+    }
+    if (read_d == 0) {
+      if (connection->exchange && connection->assembler.finishOnEof()) {
+        complete(connection);
+      } else {
+        fail(connection, "EOF");
+      }
+      return;
+    }
+    if (!connection->exchange) {
+      //  Bytes on an idle connection belong to no request
+      closeConnection(connection);
+      return;
+    }
+    connection->received = true;
+    connection->input.append(buffer, read_d);
+    bool done;
+    try {
+      done = connection->assembler.feed(connection->input);
+    } catch (const Exception &e) {
+      fail(connection, e.what());
+      return;
+    }
+    if (done) {
+      complete(connection);
+      return;
+    }
+  }
+}
+
+void AsyncHttpClient::Impl::complete(Connection *connection) {
+  unique_ptr<Exchange> exchange = std::move(connection->exchange);
+  shared_ptr<Response> response = connection->assembler.response;
+  response->uri = exchange->uri;
+  if (connection->fd >= 0) {
+    if (connection->assembler.reusable() && connection->input.empty()) {
+      idle.push_back(connection);
+      watch(connection, EPOLLIN);
+    } else {
+      closeConnection(connection);
+    }
+  }
+  finish(*exchange, response, nullptr);
+}
+
+void AsyncHttpClient::Impl::fail(Connection *connection, const string &what) {
+  unique_ptr<Exchange> exchange = std::move(connection->exchange);
+  bool stale = connection->reused && !connection->received;
+  bool unsent = connection->written == 0;
+  closeConnection(connection);
+  if (!exchange) return;
+  //  A kept-alive connection may have been closed by the daemon before the
+  //  request reached it, send it again once over another connection. A
+  //  request that was written may have run already, so only one that can
+  //  run twice is sent again
+  if (stale && !exchange->retried && (unsent || exchange->idempotent)) {
+    exchange->retried = true;
+    waiting.push_front(std::move(exchange));
+    return;
+  }
+  finish(*exchange, nullptr, std::make_exception_ptr(SocketError(what)));
+}
+
+void AsyncHttpClient::Impl::closeConnection(Connection *connection) {
+  if (connection->fd < 0) return;
+  epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection->fd, nullptr);
+  ::close(connection->fd);
+  connection->fd = -1;
+  for (auto it = idle.begin(); it != idle.end(); it++) {
+    if (*it == connection) {
+      idle.erase(it);
+      break;
+    }
+  }
+  for (auto it = connections.begin(); it != connections.end(); it++) {
+    if (it->get() == connection) {
+      closed.push_back(std::move(*it));
+      connections.erase(it);
+      break;
+    }
+  }
+}
+
+void AsyncHttpClient::Impl::watch(Connection *connection, uint32_t events) {
+  epoll_event event{};
+  event.events = events;
+  event.data.ptr = connection;
+  epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+void AsyncHttpClient::Impl::shutdown() {
+  auto error = std::make_exception_ptr(SocketError("Client is shutting down"));
+  while (!connections.empty()) {
+    Connection *connection = connections.back().get();
+    unique_ptr<Exchange> exchange = std::move(connection->exchange);
+    closeConnection(connection);
+    if (exchange) finish(*exchange, nullptr, error);
+  }
+  closed.clear();
+  takeSubmissions();
+  while (!waiting.empty()) {
+    finish(*waiting.front(), nullptr, error);
+    waiting.pop_front();
+  }
+}
+
+void AsyncHttpClient::Impl::finish(const Exchange &exchange,
+                                   shared_ptr<Response> response,
+                                   std::exception_ptr error) {
+  //  Nothing could handle an exception thrown on the loop thread
+  try {
+    exchange.callback(response, error);
+  } catch (...) {
+  }
+}
+
+//-------------------------AsyncHttpClient Implementation-------------------------//
+
+AsyncHttpClient::AsyncHttpClient(const SOCK_TYPE type, const string &path,
+                                 size_t max_connections)
+    : m_impl(new Impl(type, path, max_connections)) {}
+
+AsyncHttpClient::~AsyncHttpClient() {}
+
+void AsyncHttpClient::send(const Request &request,
+                           const CompletionCallback &callback) {
+  m_impl->send(request, callback);
+}
+
+ConnectionStats AsyncHttpClient::getConnectionStats() const {
+  return m_impl->getConnectionStats();
+}
@@ -0,0 +1,173 @@
+#include "ConnectionPool.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace DockerClientpp {
+namespace Http {
+class ConnectionPool::Impl {
+ public:
+  Impl(const SOCK_TYPE type, const string &path, const PoolOptions &options);
+  ~Impl();
+  unique_ptr<SimpleHttpClient> acquire();
+  void release(unique_ptr<SimpleHttpClient> client);
+  size_t size() const;
+  size_t idle() const;
+  size_t maxSize() const;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+  struct IdleConnection {
+    unique_ptr<SimpleHttpClient> client;
+    Clock::time_point last_used;
+  };
+
+  void reapIdle();
+  unique_ptr<SimpleHttpClient> newClient() const;
+
+  const SOCK_TYPE type;
+  const string path;
+  const PoolOptions options;
+
+  mutable std::mutex mutex;
+  std::condition_variable available;
+  //  Most recently used connection at the back
+  std::deque<IdleConnection> idle_connections;
+  size_t total;
+  //  Ticket lock, waiting callers are served in arrival order
+  unsigned long next_ticket;
+  unsigned long now_serving;
+};
+}  // namespace Http
+}  // namespace DockerClientpp
+
+using namespace DockerClientpp::Http;
+
+ConnectionPool::Impl::Impl(const SOCK_TYPE type, const string &path,
+                           const PoolOptions &options)
+    : type(type),
+      path(path),
+      options(options),
+      total(0),
+      next_ticket(0),
+      now_serving(0) {
+  if (this->options.max_size == 0) {
+    throw Exception("Connection pool max_size must be positive");
+  }
+  size_t min_size = std::min(options.min_size, options.max_size);
+  for (; total < min_size; total++) {
+    idle_connections.push_back({newClient(), Clock::now()});
+  }
+}
+
+ConnectionPool::Impl::~Impl() {}
+
+std::unique_ptr<SimpleHttpClient> ConnectionPool::Impl::acquire() {
+  std::unique_lock<std::mutex> lock(mutex);
+  unsigned long ticket = next_ticket++;
+  available.wait(lock, [&] {
+    return ticket == now_serving &&
+           (!idle_connections.empty() || total < options.max_size);
+  });
+  now_serving++;
+
+  unique_ptr<SimpleHttpClient> client;
+  try {
+    reapIdle();
+    auto expire = Clock::now() - options.idle_timeout;
+    if (!idle_connections.empty() &&
+        idle_connections.back().last_used >= expire) {
+      client = std::move(idle_connections.back().client);
+      idle_connections.pop_back();
+    } else {
+      if (!idle_connections.empty()) {
+        //  Kept for min_size but idle for too long, the daemon may have
+        //  closed it, its slot goes to a fresh connection
+        idle_connections.pop_back();
+        total--;
+      }
+      client = newClient();
+      total++;
+    }
+  } catch (...) {
+    //  The next ticket holder must not wait for a client that never comes
+    available.notify_all();
+    throw;
+  }
+  //  Let the next ticket holder check the pool
+  available.notify_all();
+  return client;
+}
+
+void ConnectionPool::Impl::release(unique_ptr<SimpleHttpClient> client) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle_connections.push_back({std::move(client), Clock::now()});
+    reapIdle();
+  }
+  available.notify_all();
+}
+
+size_t ConnectionPool::Impl::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return total;
+}
+
+size_t ConnectionPool::Impl::idle() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return idle_connections.size();
+}
+
+size_t ConnectionPool::Impl::maxSize() const {
+  return options.max_size;
+}
+
+void ConnectionPool::Impl::reapIdle() {
+  //  Must be called with mutex held
+  auto expire = Clock::now() - options.idle_timeout;
+  while (total > options.min_size && !idle_connections.empty() &&
+         idle_connections.front().last_used < expire) {
+    idle_connections.pop_front();
+    total--;
+  }
+}
+
+std::unique_ptr<SimpleHttpClient> ConnectionPool::Impl::newClient() const {
+  unique_ptr<SimpleHttpClient> client(new SimpleHttpClient(type, path));
+  if (options.recorder) client->setRecorder(options.recorder);
+  if (options.replayer) client->setReplayer(options.replayer);
+  client->setTimeouts(options.timeouts);
+  return client;
+}
+
+//-------------------------ConnectionPool Implementation-------------------------//
+
+ConnectionPool::Lease::Lease(Impl *pool, unique_ptr<SimpleHttpClient> client)
+    : pool(pool), client(std::move(client)) {}
+
+ConnectionPool::Lease::~Lease() {
+  if (client) pool->release(std::move(client));
+}
+
+ConnectionPool::ConnectionPool(const SOCK_TYPE type, const string &path,
+                               const PoolOptions &options)
+    : m_impl(new Impl(type, path, options)) {}
+
+ConnectionPool::~ConnectionPool() {}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+  return Lease(m_impl.get(), m_impl->acquire());
+}
+
+size_t ConnectionPool::size() const {
+  return m_impl->size();
+}
+
+size_t ConnectionPool::idle() const {
+  return m_impl->idle();
+}
+
+size_t ConnectionPool::maxSize() const {
+  return m_impl->maxSize();
+}
@@ -1,31 +1,52 @@
+#include "ConnectionPool.hpp"
 #include "DockerClient.hpp"
+#include "Operations.hpp"
 #include "SimpleHttpClient.hpp"
 
+#include <atomic>
 #include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace DockerClientpp {
 class DockerClient::Impl {
  public:
-  Impl(const SOCK_TYPE type, const string &path);
+  Impl(const SOCK_TYPE type, const string &path,
+       const Http::PoolOptions &pool_options);
   ~Impl();
   void setAPIVersion(const string &api);
-  string getLongId(const std::string &name);
+  string getLongId(const std::string &name, bool bypass_cache);
   std::vector<std::string> listImages();
   string createContainer(const json &config, const string &name = "");
   void startContainer(const string &identifier);
-  string inspectContainer(const string &id);
+  string inspectContainer(const string &id, bool bypass_cache);
+  ContainerInfo inspectContainerInfo(const string &id);
+  std::vector<InspectResult> inspectContainers(const vector<string> &ids,
+                                               size_t concurrency);
   void stopContainer(const string &identifier);
   void removeContainer(const string &identifier, bool remove_volume, bool force,
                        bool remove_link);
   string createExecution(const string &identifier, const json &config);
   string startExecution(const string &id, const json &config);
+  void startExecution(const string &id, const json &config,
+                      const Http::FrameSink &sink);
   string inspectExecution(const string &id);
+  ExecInfo inspectExecutionInfo(const string &id);
   string getContainerStats(const string &id);
+  StatsSample getContainerStatsSample(const string &id);
+  void streamContainerStats(const string &id, const StatsCallback &callback);
+  void streamEvents(const EventOptions &options,
+                    const EventCallback &callback);
+  void enableInspectCache(bool enable);
+  std::exception_ptr inspectCacheError();
   json downloadImage(const string &imageName, const string &tag, const json &config);
   json commitImage(const string &idOrName, const string &repo, const string &message, const string &tag, const json &config);
     void killContainer(const std::string &idOrName);
   int waitContainer(const std::string &idOrName, const std::string &condition = "not-running");
   string getLogs(const string &id,bool stdoutFlag=true, bool stderrFlag=true, int tail=-1);
+  void streamLogs(const string &id, const LogOptions &options,
+                  const Http::FrameSink &sink);
   ExecRet executeCommand(const string &identifier, const vector<string> &cmd);
   void putFiles(const string &identifier, const vector<string> &files,
                 const string &path);
@@ -34,10 +55,50 @@ class DockerClient::Impl {
   void updateContainer(const std::string &id, const json &config);
   std::vector<std::string> getRunningContainers();
  private:
+  struct CacheEntry {
+    string body;
+    string long_id;
+  };
+
   Http::Header createCommonHeader(size_t content_length);
+  void configureStream(Http::SimpleHttpClient &client);
+  void followEvents(const EventOptions &options, const EventCallback &callback,
+                    Http::SimpleHttpClient &stream_client,
+                    const std::atomic<bool> &cancelled,
+                    const std::function<void()> &on_connected = nullptr);
+  CacheEntry inspectCached(const string &id);
+  void invalidate(const Event &event);
+  void stopInspectCache();
+
+  template <class Operation, class... Args>
+  typename Operation::Result call(Args &&... args) {
+    Http::Request request = Operation::request(std::forward<Args>(args)...);
+    Operations::prepare(request, api_version);
+    shared_ptr<Http::Response> res = pool.acquire()->Send(request);
+    return Operation::result(request, *res);
+  }
 
-  Http::SimpleHttpClient http_client;
+  Http::ConnectionPool pool;
+  //  Long lived streams get their own connection instead of a pooled one
+  const SOCK_TYPE sock_type;
+  const string sock_path;
+  //  Given to stream connections as the pool gives them to its own
+  const shared_ptr<Recorder> recorder;
+  const shared_ptr<Replayer> replayer;
+  const Http::Timeouts timeouts;
   string api_version;
+
+  //  Inspect results kept until /events reports a change of the container
+  std::atomic<bool> cache_enabled;
+  std::mutex cache_mutex;
+  std::unordered_map<string, CacheEntry> cache;
+  //  Bumped by every invalidation, a result requested before it is stale
+  unsigned long cache_generation;
+  unique_ptr<Http::SimpleHttpClient> event_client;
+  std::atomic<bool> cache_stopping;
+  //  What ended the events subscription, guarded by cache_mutex
+  std::exception_ptr cache_error;
+  std::thread cache_thread;
 };
 }  // namespace DockerClientpp
 
@@ -45,73 +106,35 @@ using namespace DockerClientpp;
 using namespace Http;
 using namespace Utility;
 
-DockerClient::Impl::Impl(const SOCK_TYPE type, const string &path)
-    : http_client(type, path), api_version("v1.24") {}
+const size_t INSPECT_BATCH_SIZE = 16;
 
-DockerClient::Impl::~Impl() {}
+DockerClient::Impl::Impl(const SOCK_TYPE type, const string &path,
+                         const Http::PoolOptions &pool_options)
+    : pool(type, path, pool_options),
+      sock_type(type),
+      sock_path(path),
+      recorder(pool_options.recorder),
+      replayer(pool_options.replayer),
+      timeouts(pool_options.timeouts),
+      api_version("v1.24"),
+      cache_enabled(false),
+      cache_generation(0),
+      cache_stopping(false) {}
+
+DockerClient::Impl::~Impl() {
+  stopInspectCache();
+}
 
 void DockerClient::Impl::setAPIVersion(const string &api) {
   api_version = api;
 }
 
 std::vector<std::string> DockerClient::Impl::listImages() {
-  Header header = createCommonHeader(0);
-  Uri uri = "/images/json";
-  shared_ptr<Response> res = http_client.Get(uri, header, {});
-  switch (res->status_code) {
-    case 200: {
-      break;
-    }
-    default:
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-      break;
-  }
-    std::vector<std::string> names;
-
-    json body = json::parse(res->body);
-    for(const auto& elem: body){
-        bool done = false;
-        for(const auto &entry: elem["RepoTags"]) {
-            string tagName = entry.get<std::string>();
-            size_t pos = tagName.find("latest");
-            if(pos != std::string::npos) {
-                const string name = tagName.substr(0, pos-1);
-                names.push_back(name);
-                done = true;
-                break;
-            }
-        }
-        if(!done && elem["RepoTags"].size() > 0) {
-            names.push_back(elem["RepoTags"].back().get<std::string>());
-        }
-    }
-    return names;
+  return call<Operations::ListImages>();
 }
 
-
-std::vector<std::string> DockerClient::Impl::getRunningContainers(){
-  std::vector<std::string> names;
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/json";
-  shared_ptr<Response> res = http_client.Get(uri, header, {});
-  switch (res->status_code) {
-    case 200: {
-      break;
-    }
-    default:
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-      break;
-  }
-
-  json body = json::parse(res->body);
-  for(const auto& elem:body){
-    names.push_back(elem["Names"].back().get<std::string>().substr(1));
-  }
-  return names;
+std::vector<std::string> DockerClient::Impl::getRunningContainers() {
+  return call<Operations::GetRunningContainers>();
 }
 
 Http::Header DockerClient::Impl::createCommonHeader(size_t content_length) {
@@ -123,102 +146,52 @@ Http::Header DockerClient::Impl::createCommonHeader(size_t content_length) {
   };
 }
 
+void DockerClient::Impl::configureStream(SimpleHttpClient &client) {
+  if (recorder) client.setRecorder(recorder);
+  if (replayer) client.setReplayer(replayer);
+  //  A stream lasts as long as the caller wants, only its start is bounded
+  Timeouts stream_timeouts = timeouts;
+  stream_timeouts.total = std::chrono::milliseconds(0);
+  client.setTimeouts(stream_timeouts);
+}
+
 string DockerClient::Impl::createContainer(const json &config,
                                            const string &name) {
-  QueryParam query_param{};
-  if (!name.empty()) {
-    query_param["name"] = name;
-  }
-
-  string post_data = config.dump();
-  Header header = createCommonHeader(post_data.size());
-  Uri uri = "/containers/create";
-  shared_ptr<Response> res =
-      http_client.Post(uri, header, query_param, post_data);
-  json body = json::parse(res->body);
-  switch (res->status_code) {
-    case 201:
-      break;
-    default:
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-  }
-  return body["Id"];
+  return call<Operations::CreateContainer>(config, name);
 }
 
 void DockerClient::Impl::startContainer(const string &identifier) {
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + identifier + "/start";
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, "");
-  switch (res->status_code) {
-    case 204:
-      break;
-    default: {
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-    }
-  }
+  call<Operations::StartContainer>(identifier);
 }
 
 void DockerClient::Impl::stopContainer(const string &identifier) {
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + identifier + "/stop";
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, "");
-  switch (res->status_code) {
-    case 204:
-      break;
-    default: {
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-    }
-  }
+  call<Operations::StopContainer>(identifier);
 }
 
 void DockerClient::Impl::removeContainer(const string &identifier,
                                          bool remove_volume, bool force,
                                          bool remove_link) {
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + identifier;
-  QueryParam query_param{{"v", std::to_string(remove_volume)},
-                         {"force", std::to_string(force)},
-                         {"link", std::to_string(remove_link)}};
-  shared_ptr<Response> res = http_client.Delete(uri, header, query_param);
-  switch (res->status_code) {
-    case 204:
-      break;
-    default: {
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-    }
-  }
+  call<Operations::RemoveContainer>(identifier, remove_volume, force,
+                                    remove_link);
 }
 
 string DockerClient::Impl::createExecution(const string &identifier,
                                            const json &config) {
-  string post_data = config.dump();
-  Header header = createCommonHeader(post_data.size());
-  Uri uri = "/containers/" + identifier + "/exec";
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, post_data);
-  json body = json::parse(res->body);
-  switch (res->status_code) {
-    case 201:
-      break;
-    default:
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-  }
-  return body["Id"];
+  return call<Operations::CreateExecution>(identifier, config);
 }
 
 string DockerClient::Impl::startExecution(const string &id,
                                           const json &config) {
+  return call<Operations::StartExecution>(id, config);
+}
+
+void DockerClient::Impl::startExecution(const string &id, const json &config,
+                                        const FrameSink &sink) {
   string post_data = config.dump();
   Header header = createCommonHeader(post_data.size());
   Uri uri = "/exec/" + id + "/start";
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, post_data);
+  shared_ptr<Response> res =
+      pool.acquire()->PostMultiplexed(uri, header, {}, post_data, sink);
   switch (res->status_code) {
     case 200:
       break;
@@ -227,31 +200,33 @@ string DockerClient::Impl::startExecution(const string &id,
       throw DockerOperationError(uri, res->status_code,
                                  body["message"].get<string>());
   }
-  return res->body;
 }
 
-void DockerClient::Impl::updateContainer(const std::string &id, const json &config){
-  string post_data = config.dump();
-  Header header = createCommonHeader(post_data.size());
-  Uri uri = "/containers/" + id + "/update";
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, post_data);
-  switch (res->status_code) {
-    case 200:
-      break;
-    default:
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-  }
+void DockerClient::Impl::updateContainer(const std::string &id,
+                                         const json &config) {
+  call<Operations::UpdateContainer>(id, config);
 }
 
+string DockerClient::Impl::getContainerStats(const string &id) {
+  return call<Operations::GetContainerStats>(id);
+}
 
-string DockerClient::Impl::getContainerStats(const string &id){
-  bool stream = false;
+StatsSample DockerClient::Impl::getContainerStatsSample(const string &id) {
+  return call<Operations::GetContainerStatsSample>(id);
+}
+
+void DockerClient::Impl::streamContainerStats(const string &id,
+                                              const StatsCallback &callback) {
   Header header = createCommonHeader(0);
   Uri uri = "/containers/" + id + "/stats";
-  QueryParam query_param{{"stream", (stream)?"1":"0"}};
-  shared_ptr<Response> res = http_client.Get(uri, header, query_param);
+  QueryParam query_param{{"stream", "1"}};
+  Utility::JsonLineDecoder decoder;
+  SimpleHttpClient stream_client(sock_type, sock_path);
+  configureStream(stream_client);
+  shared_ptr<Response> res = stream_client.GetStream(
+      uri, header, query_param, [&](const char *data, size_t size) {
+        return decoder.feed(data, size, callback);
+      });
   switch (res->status_code) {
     case 200:
       break;
@@ -260,44 +235,144 @@ string DockerClient::Impl::getContainerStats(const string &id){
       throw DockerOperationError(uri, res->status_code,
                                  body["message"].get<string>());
   }
-  return res->body;
 }
 
+namespace {
+/**
+ * @brief Id of an inspect result, the scan stops as soon as it is found
+ */
+string scanId(const string &text) {
+  JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "Id") return scanner.readString();
+    scanner.skipValue();
+  }
+  throw ParseError("Inspect result has no Id");
+}
+
+string stringField(const json &object, const char *key) {
+  auto it = object.find(key);
+  if (it == object.end() || !it->is_string()) return string();
+  return it->get<string>();
+}
+
+Event toEvent(const json &value) {
+  Event event;
+  event.type = stringField(value, "Type");
+  event.action = stringField(value, "Action");
+  if (event.action.empty()) event.action = stringField(value, "status");
+  auto actor_it = value.find("Actor");
+  if (actor_it != value.end() && actor_it->is_object()) {
+    event.id = stringField(*actor_it, "ID");
+    auto attributes_it = actor_it->find("Attributes");
+    if (attributes_it != actor_it->end() && attributes_it->is_object()) {
+      for (auto it = attributes_it->begin(); it != attributes_it->end();
+           it++) {
+        if (it.value().is_string()) event.attributes[it.key()] = it.value();
+      }
+    }
+  }
+  if (event.id.empty()) event.id = stringField(value, "id");
+  event.scope = stringField(value, "scope");
+  auto time_it = value.find("time");
+  if (time_it != value.end() && time_it->is_number()) {
+    event.time = time_it->get<long>();
+  }
+  auto nano_it = value.find("timeNano");
+  if (nano_it != value.end() && nano_it->is_number()) {
+    event.time_nano = nano_it->get<long long>();
+  } else {
+    event.time_nano = event.time * 1000000000LL;
+  }
+  return event;
+}
+
+string formatTimeNano(long long time_nano) {
+  //  Docker accepts "seconds.nanoseconds" for since and until
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%lld.%09lld", time_nano / 1000000000LL,
+           time_nano % 1000000000LL);
+  return buffer;
+}
+}  // namespace
 
-void DockerClient::Impl::killContainer(const std::string &idOrName){
+void DockerClient::Impl::streamEvents(const EventOptions &options,
+                                      const EventCallback &callback) {
+  SimpleHttpClient stream_client(sock_type, sock_path);
+  configureStream(stream_client);
+  std::atomic<bool> cancelled(false);
+  followEvents(options, callback, stream_client, cancelled);
+}
 
-  ///containers/(id or name)/kill
+void DockerClient::Impl::followEvents(
+    const EventOptions &options, const EventCallback &callback,
+    SimpleHttpClient &stream_client, const std::atomic<bool> &cancelled,
+    const std::function<void()> &on_connected) {
   Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + idOrName + "/kill";
+  Uri uri = "/events";
+  QueryParam query_param;
+  if (options.since != 0) {
+    query_param["since"] = std::to_string(options.since);
+  }
+  if (options.until != 0) {
+    query_param["until"] = std::to_string(options.until);
+  }
+  if (!options.filters.empty()) {
+    query_param["filters"] =
+        Utility::percentEncode(json(options.filters).dump());
+  }
 
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, {});
-  switch (res->status_code) {
-    case 204:
-    case 404:
-      break;
-    default:
+  long long last_time_nano = 0;
+  bool stopped = false;
+  long connected_at = time(nullptr);
+  while (true) {
+    shared_ptr<Response> res;
+    Utility::JsonLineDecoder decoder;
+    try {
+      res = stream_client.GetStream(
+          uri, header, query_param, [&](const char *data, size_t size) {
+            return decoder.feed(data, size, [&](const json &value) {
+              Event event = toEvent(value);
+              last_time_nano = std::max(last_time_nano, event.time_nano);
+              if (!callback(event)) stopped = true;
+              return !stopped;
+            });
+          },
+          [&](const Response &response) {
+            if (response.status_code == 200 && on_connected) on_connected();
+          });
+    } catch (const SocketError &) {
+      if (cancelled) return;
+      if (!options.reconnect) throw;
+    }
+    if (res && res->status_code != 200) {
       json body = json::parse(res->body);
       throw DockerOperationError(uri, res->status_code,
                                  body["message"].get<string>());
+    }
+    if (stopped || cancelled || !options.reconnect) return;
+    if (options.until != 0 && time(nullptr) >= options.until) return;
+
+    std::this_thread::sleep_for(options.reconnect_delay);
+    //  Resume right after the last event, or from the first connection if
+    //  nothing arrived, so no event is lost or repeated
+    if (last_time_nano != 0) {
+      query_param["since"] = formatTimeNano(last_time_nano + 1);
+    } else if (options.since == 0) {
+      query_param["since"] = std::to_string(connected_at);
+    }
   }
 }
 
-int DockerClient::Impl::waitContainer(const std::string &idOrName, const std::string &condition){
-  ///containers/(id or name)/kill
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + idOrName + "/wait?condition=" + condition;
+void DockerClient::Impl::killContainer(const std::string &idOrName) {
+  call<Operations::KillContainer>(idOrName);
+}
 
-  shared_ptr<Response> res = http_client.Post(uri, header, {}, {});
-  json body = json::parse(res->body);
-  switch (res->status_code) {
-    case 200:
-    case 404:
-      break;
-    default:
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
-  }
-  return body["StatusCode"];  
+int DockerClient::Impl::waitContainer(const std::string &idOrName,
+                                      const std::string &condition) {
+  return call<Operations::WaitContainer>(idOrName, condition);
 }
 
 //POST /v1.24/images/create?fromImage=busybox&tag=latest HTTP/1.1
@@ -309,7 +384,7 @@ json DockerClient::Impl::downloadImage(const string &imageName, const string &ta
   QueryParam query_param{{"fromImage", imageName}};
   query_param.insert({"tag",tag});
   shared_ptr<Response> res =
-      http_client.Post(uri, header, query_param, post_data);
+      pool.acquire()->Post(uri, header, query_param, post_data);
   std::string body;
   if(!res->body.empty()){
     body = "["+res->body+']';
@@ -349,7 +424,7 @@ json DockerClient::Impl::commitImage(const string &idOrName, const string &repo,
         {"tag", tag}
     };
     shared_ptr<Response> res =
-            http_client.Post(uri, header, query_param, post_data);
+            pool.acquire()->Post(uri, header, query_param, post_data);
     std::string body;
     if(!res->body.empty()){
         body = "["+res->body+']';
@@ -376,46 +451,229 @@ json DockerClient::Impl::commitImage(const string &idOrName, const string &repo,
 }
 
 string DockerClient::Impl::inspectExecution(const string &id) {
-  Header header = createCommonHeader(0);
-  Uri uri = "/exec/" + id + "/json";
-  shared_ptr<Response> res = http_client.Get(uri, header, {});
-  switch (res->status_code) {
-    case 200:
-      break;
-    default:
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
+  return call<Operations::InspectExecution>(id);
+}
+
+ExecInfo DockerClient::Impl::inspectExecutionInfo(const string &id) {
+  return call<Operations::InspectExecutionInfo>(id);
+}
+
+ContainerInfo DockerClient::Impl::inspectContainerInfo(const string &id) {
+  return call<Operations::InspectContainerInfo>(id);
+}
+
+string DockerClient::Impl::inspectContainer(const string &id,
+                                            bool bypass_cache) {
+  if (bypass_cache || !cache_enabled) {
+    return call<Operations::InspectContainer>(id);
   }
-  return res->body;
+  return inspectCached(id).body;
 }
 
-string DockerClient::Impl::inspectContainer(const string &id) {
-  Header header = createCommonHeader(0);
-  Uri uri = "/containers/" + id + "/json";
-  shared_ptr<Response> res = http_client.Get(uri, header, {});
-  switch (res->status_code) {
-    case 200:
-      break;
-    default:
-      json body = json::parse(res->body);
-      throw DockerOperationError(uri, res->status_code,
-                                 body["message"].get<string>());
+DockerClient::Impl::CacheEntry DockerClient::Impl::inspectCached(
+    const string &id) {
+  unsigned long generation;
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(id);
+    if (it != cache.end()) return it->second;
+    generation = cache_generation;
+  }
+  CacheEntry entry;
+  entry.body = call<Operations::InspectContainer>(id);
+  entry.long_id = scanId(entry.body);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  if (generation == cache_generation && cache_enabled) {
+    cache[id] = entry;
+  }
+  return entry;
+}
+
+void DockerClient::Impl::invalidate(const Event &event) {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  cache_generation++;
+  auto name_it = event.attributes.find("name");
+  for (auto it = cache.begin(); it != cache.end();) {
+    //  Entries are keyed by whatever the caller passed, id, short id or name
+    if (it->second.long_id == event.id || it->first == event.id ||
+        (name_it != event.attributes.end() && it->first == name_it->second)) {
+      it = cache.erase(it);
+    } else {
+      it++;
+    }
   }
-  return res->body;
 }
 
+void DockerClient::Impl::enableInspectCache(bool enable) {
+  stopInspectCache();
+  {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache_error = nullptr;
+  }
+  if (!enable) return;
+  EventOptions options;
+  //  Events from now on are replayed if the subscription starts late
+  options.since = time(nullptr);
+  options.filters = {{"type", {"container"}}};
+  options.reconnect_delay = std::chrono::milliseconds(100);
+  event_client.reset(new SimpleHttpClient(sock_type, sock_path));
+  configureStream(*event_client);
+  cache_stopping = false;
+  cache_thread = std::thread([this, options] {
+    std::exception_ptr error;
+    try {
+      followEvents(options,
+                   [this](const Event &event) {
+                     invalidate(event);
+                     return true;
+                   },
+                   *event_client, cache_stopping,
+                   //  Only results fetched while the subscription is live
+                   //  are sure to be invalidated
+                   [this] { cache_enabled = true; });
+    } catch (...) {
+      error = std::current_exception();
+    }
+    //  Without events nothing could be trusted any more
+    cache_enabled = false;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+    cache_error = error;
+  });
+}
+
+std::exception_ptr DockerClient::Impl::inspectCacheError() {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  return cache_error;
+}
+
+void DockerClient::Impl::stopInspectCache() {
+  if (!cache_thread.joinable()) return;
+  cache_stopping = true;
+  //  Wakes a blocked read, or makes the next connect fail if the thread is
+  //  between two connections
+  event_client->shutdown();
+  cache_thread.join();
+  event_client.reset();
+}
+
+std::vector<InspectResult> DockerClient::Impl::inspectContainers(
+    const vector<string> &ids, size_t concurrency) {
+  std::vector<InspectResult> results(ids.size());
+  std::atomic<size_t> next(0);
+  //  Every batch of every worker has to finish within one budget
+  DeadlineScope budget(timeouts.total);
+  DeadlineScope::Clock::time_point deadline = DeadlineScope::current();
+  //  Runs on its own thread, so every error must end up in the results
+  auto work = [&] {
+    DeadlineScope worker_budget(deadline);
+    size_t begin;
+    try {
+      //  One connection per worker, batches are pipelined on it
+      auto connection = pool.acquire();
+      while ((begin = next.fetch_add(INSPECT_BATCH_SIZE)) < ids.size()) {
+        size_t end = std::min(begin + INSPECT_BATCH_SIZE, ids.size());
+        for (size_t i = begin; i < end; i++) {
+          results[i].id = ids[i];
+        }
+        try {
+          vector<Request> requests;
+          for (size_t i = begin; i < end; i++) {
+            requests.push_back(Operations::InspectContainer::request(ids[i]));
+            Operations::prepare(requests.back(), api_version);
+          }
+          auto responses = connection->Pipeline(requests);
+          for (size_t i = begin; i < end; i++) {
+            try {
+              results[i].body = Operations::InspectContainer::result(
+                  requests[i - begin], *responses[i - begin]);
+            } catch (...) {
+              results[i].error = std::current_exception();
+            }
+          }
+        } catch (...) {
+          for (size_t i = begin; i < end; i++) {
+            results[i].error = std::current_exception();
+          }
+        }
+      }
+    } catch (...) {
+      //  Without a connection every batch the worker claims fails alike
+      std::exception_ptr error = std::current_exception();
+      while ((begin = next.fetch_add(INSPECT_BATCH_SIZE)) < ids.size()) {
+        size_t end = std::min(begin + INSPECT_BATCH_SIZE, ids.size());
+        for (size_t i = begin; i < end; i++) {
+          results[i].id = ids[i];
+          results[i].error = error;
+        }
+      }
+    }
+  };
+
+  size_t batches = (ids.size() + INSPECT_BATCH_SIZE - 1) / INSPECT_BATCH_SIZE;
+  //  Workers beyond the pool size would only wait for a connection
+  size_t workers = std::min({std::max<size_t>(concurrency, 1), batches,
+                             pool.maxSize()});
+  {
+    std::vector<std::thread> threads;
+    //  Joined however the block is left, before results are read. A
+    //  joinable thread destroyed on the way out would terminate the process
+    struct Joiner {
+      std::vector<std::thread> &threads;
+      ~Joiner() {
+        for (auto &thread : threads) thread.join();
+      }
+    } joiner{threads};
+    for (size_t i = 1; i < workers; i++) {
+      threads.emplace_back(work);
+    }
+    if (workers > 0) work();
+  }
+  return results;
+}
 
+string DockerClient::Impl::getLogs(const string &id, bool stdoutFlag,
+                                   bool stderrFlag, int tail) {
+  return call<Operations::GetLogs>(id, stdoutFlag, stderrFlag, tail);
+}
 
-string DockerClient::Impl::getLogs(const string &id,bool stdoutFlag, bool stderrFlag, int tail) {
+void DockerClient::Impl::streamLogs(const string &id,
+                                    const LogOptions &options,
+                                    const FrameSink &sink) {
   Header header = createCommonHeader(0);
-  QueryParam query_param{{"stdout", (stdoutFlag)?"1":"0"},
-                         {"stderr", (stderrFlag)?"1":"0"}};
-  if(tail!=-1){
-    query_param.emplace("tail",std::to_string(tail));
+  QueryParam query_param{{"stdout", options.std_out ? "1" : "0"},
+                         {"stderr", options.std_err ? "1" : "0"},
+                         {"follow", options.follow ? "1" : "0"},
+                         {"timestamps", options.timestamps ? "1" : "0"}};
+  if (options.since != 0) {
+    query_param.emplace("since", std::to_string(options.since));
+  }
+  if (options.until != 0) {
+    query_param.emplace("until", std::to_string(options.until));
+  }
+  if (options.tail != -1) {
+    query_param.emplace("tail", std::to_string(options.tail));
   }
   Uri uri = "/containers/" + id + "/logs";
-  shared_ptr<Response> res = http_client.Get(uri, header, query_param);
+
+  auto request = [&](SimpleHttpClient &client) {
+    if (options.tty) {
+      //  Tty output has no frames, everything is stdout
+      return client.GetStream(uri, header, query_param,
+                              [&sink](const char *data, size_t size) {
+                                return sink(STREAM_STDOUT, data, size);
+                              });
+    }
+    return client.GetMultiplexed(uri, header, query_param, sink);
+  };
+  shared_ptr<Response> res;
+  if (options.follow) {
+    SimpleHttpClient stream_client(sock_type, sock_path);
+    configureStream(stream_client);
+    res = request(stream_client);
+  } else {
+    res = request(*pool.acquire());
+  }
   switch (res->status_code) {
     case 200:
       break;
@@ -424,19 +682,49 @@ string DockerClient::Impl::getLogs(const string &id,bool stdoutFlag, bool stderr
       throw DockerOperationError(uri, res->status_code,
                                  body["message"].get<string>());
   }
-  return res->body;
 }
 
 ExecRet DockerClient::Impl::executeCommand(const string &identifier,
                                            const vector<string> &cmd) {
+  //  Create, start and inspect share one budget
+  DeadlineScope budget(timeouts.total);
   string id = this->createExecution(identifier, {{"AttachStdout", true},
                                                  {"AttachStderr", true},
                                                  {"Tty", false},
                                                  {"Cmd", cmd}});
   ExecRet ret;
-  ret.output = this->startExecution(id, {{"Detach", false}, {"Tty", false}});
-  json status = json::parse(this->inspectExecution(id));
-  ret.ret_code = status["ExitCode"].get<int>();
+  string post_data = json({{"Detach", false}, {"Tty", false}}).dump();
+  Header header = createCommonHeader(post_data.size());
+  Uri uri = "/exec/" + id + "/start";
+  shared_ptr<Response> res = pool.acquire()->Post(
+      uri, header, {}, post_data, [&ret](Response &res, BodyReader &body) {
+        if (res.status_code != 200) {
+          res.body = body.readAll();
+          return;
+        }
+        //  Payloads are read straight into the stream they belong to
+        StreamDemuxer demuxer(body);
+        STREAM_TYPE type;
+        size_t size;
+        while (demuxer.nextFrame(type, size)) {
+          string &target = type == STREAM_STDERR ? ret.std_err : ret.std_out;
+          size_t offset = target.size();
+          target.resize(offset + size);
+          for (size_t total = 0; total < size;) {
+            total += demuxer.read(&target[offset + total], size - total);
+          }
+          ret.output.append(target, offset, size);
+        }
+      });
+  switch (res->status_code) {
+    case 200:
+      break;
+    default:
+      json body = json::parse(res->body);
+      throw DockerOperationError(uri, res->status_code,
+                                 body["message"].get<string>());
+  }
+  ret.ret_code = this->inspectExecutionInfo(id).exit_code;
   return ret;
 }
 
@@ -445,13 +733,16 @@ void DockerClient::Impl::putFiles(const string &identifier,
                                   const string &path) {
   Utility::Archive ar;
   ar.addFiles(files);
-  string put_data = ar.getTar();
-  Header header = createCommonHeader(put_data.size());
+  //  Stream the tar while it is built instead of holding it in memory
+  Header header = createCommonHeader(0);
+  header.erase("Content-Length");
+  header["Transfer-Encoding"] = "chunked";
   Uri uri = "/containers/" + identifier + "/archive";
   header["Content-Type"] = "application/x-tar";
   QueryParam query_param{{"path", path}};
-  shared_ptr<Response> res =
-      http_client.Put(uri, header, query_param, put_data);
+  shared_ptr<Response> res = pool.acquire()->Put(
+      uri, header, query_param,
+      [&ar](const BodyWriter &writer) { ar.writeTo(writer); });
   switch (res->status_code) {
     case 200:
       break;
@@ -466,7 +757,19 @@ void DockerClient::Impl::getFile(const string &identifier, const string &file,
                                  const string &path) {
   Header header = createCommonHeader(0);
   Uri uri = "/containers/" + identifier + "/archive";
-  shared_ptr<Response> res = http_client.Get(uri, header, {{"path", file}});
+  //  Extract entries while the tar arrives instead of buffering all of it
+  shared_ptr<Response> res = pool.acquire()->Get(
+      uri, header, {{"path", file}}, [&path](Response &res, BodyReader &body) {
+        if (res.status_code != 200) {
+          res.body = body.readAll();
+          return;
+        }
+        Utility::Archive::extractTar(
+            [&body](char *buffer, size_t size) {
+              return body.read(buffer, size);
+            },
+            path);
+      });
   switch (res->status_code) {
     case 200:
       break;
@@ -475,20 +778,21 @@ void DockerClient::Impl::getFile(const string &identifier, const string &file,
       throw DockerOperationError(uri, res->status_code,
                                  body["message"].get<string>());
   }
-
-  Utility::Archive::extractTar(res->body, path);
 }
 
-std::string DockerClient::Impl::getLongId(const std::string &name){
-  const auto info =  this->inspectContainer(name);
-  const json message = json::parse(info);
-  return message.at("Id");
+std::string DockerClient::Impl::getLongId(const std::string &name,
+                                          bool bypass_cache) {
+  if (bypass_cache || !cache_enabled) {
+    return call<Operations::GetLongId>(name);
+  }
+  return inspectCached(name).long_id;
 }
 
 //-------------------------DockerClient Implementation-------------------------
 
-DockerClient::DockerClient(const SOCK_TYPE type, const string &path)
-    : m_impl(new Impl(type, path)) {}
+DockerClient::DockerClient(const SOCK_TYPE type, const string &path,
+                           const Http::PoolOptions &pool_options)
+    : m_impl(new Impl(type, path, pool_options)) {}
 
 DockerClient::~DockerClient() {}
 
@@ -508,6 +812,15 @@ string DockerClient::getContainerStats(const std::string &id){
   return m_impl->getContainerStats(id);
 }
 
+StatsSample DockerClient::getContainerStatsSample(const string &id) {
+  return m_impl->getContainerStatsSample(id);
+}
+
+void DockerClient::streamContainerStats(const string &id,
+                                        const StatsCallback &callback) {
+  m_impl->streamContainerStats(id, callback);
+}
+
 json DockerClient::downloadImage(const string &imageName, const string &tag, const json &config){
   return m_impl->downloadImage(imageName,tag,config);
 }
@@ -538,12 +851,25 @@ string DockerClient::startExecution(const string &id, const json &config) {
   return m_impl->startExecution(id, config);
 }
 
+void DockerClient::startExecution(const string &id, const json &config,
+                                  const Http::FrameSink &sink) {
+  m_impl->startExecution(id, config, sink);
+}
+
 string DockerClient::inspectExecution(const string &id) {
   return m_impl->inspectExecution(id);
 }
 
-string DockerClient::inspectContainer(const string &id) {
-  return m_impl->inspectContainer(id);
+ExecInfo DockerClient::inspectExecutionInfo(const string &id) {
+  return m_impl->inspectExecutionInfo(id);
+}
+
+string DockerClient::inspectContainer(const string &id, bool bypass_cache) {
+  return m_impl->inspectContainer(id, bypass_cache);
+}
+
+ContainerInfo DockerClient::inspectContainerInfo(const string &id) {
+  return m_impl->inspectContainerInfo(id);
 }
 
 ExecRet DockerClient::executeCommand(const string &identifier,
@@ -561,7 +887,6 @@ void DockerClient::getFile(const string &identifier, const string &file,
   m_impl->getFile(identifier, file, path);
 }
 
-
 void DockerClient::killContainer(const std::string &idOrName){
   m_impl->killContainer(idOrName); 
 }
@@ -573,15 +898,36 @@ int DockerClient::waitContainer(const std::string &idOrName, const std::string &
 string DockerClient::getLogs(const string &id,bool stdoutFlag, bool stderrFlag, int tail){
   return m_impl->getLogs(id,stdoutFlag,stderrFlag,tail);
 }
+void DockerClient::streamLogs(const string &id, const LogOptions &options,
+                              const Http::FrameSink &sink) {
+  m_impl->streamLogs(id, options, sink);
+}
+
 void DockerClient::updateContainer(const std::string &id, const json &config){
   m_impl->updateContainer(id,config);
 }
 
+void DockerClient::streamEvents(const EventOptions &options,
+                                const EventCallback &callback) {
+  m_impl->streamEvents(options, callback);
+}
+
+string DockerClient::getLongId(const std::string &name, bool bypass_cache) {
+  return m_impl->getLongId(name, bypass_cache);
+}
 
-string DockerClient::getLongId(const std::string &name){
-  return m_impl->getLongId(name);
+void DockerClient::enableInspectCache(bool enable) {
+  m_impl->enableInspectCache(enable);
 }
 
+std::exception_ptr DockerClient::inspectCacheError() {
+  return m_impl->inspectCacheError();
+}
+
+std::vector<InspectResult> DockerClient::inspectContainers(
+    const vector<string> &ids, size_t concurrency) {
+  return m_impl->inspectContainers(ids, concurrency);
+}
 
 std::vector<std::string> DockerClient::getRunningContainers(){
   return m_impl->getRunningContainers();  
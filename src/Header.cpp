@@ -0,0 +1,94 @@
+#include "Header.hpp"
+#include "Exceptions.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <strings.h>
+#include <tuple>
+
+using namespace DockerClientpp;
+using namespace Http;
+
+namespace {
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+}  // namespace
+
+Header::Header(std::initializer_list<Field> fields) : fields(fields) {}
+
+Header::const_iterator Header::findName(const char *name, size_t size) const {
+  return std::find_if(fields.begin(), fields.end(), [&](const Field &field) {
+    return field.first.size() == size &&
+           strncasecmp(field.first.data(), name, size) == 0;
+  });
+}
+
+Header::iterator Header::find(const char *name) {
+  return fields.begin() + (findName(name, strlen(name)) - fields.cbegin());
+}
+
+Header::const_iterator Header::find(const char *name) const {
+  return findName(name, strlen(name));
+}
+
+Header::iterator Header::find(const string &name) {
+  auto it = findName(name.data(), name.size());
+  return fields.begin() + (it - fields.cbegin());
+}
+
+Header::const_iterator Header::find(const string &name) const {
+  return findName(name.data(), name.size());
+}
+
+string &Header::operator[](const string &name) {
+  auto it = find(name);
+  if (it != fields.end()) return it->second;
+  fields.emplace_back(name, string());
+  return fields.back().second;
+}
+
+void Header::add(string name, string value) {
+  fields.emplace_back(std::move(name), std::move(value));
+}
+
+void Header::parseLine(const char *begin, const char *end) {
+  const char *colon = std::find(begin, end, ':');
+  if (colon == end) {
+    throw ParseError("Parse http header error, which is: " +
+                     string(begin, end));
+  }
+  const char *value = colon + 1;
+  while (value != end && isSpace(*value)) ++value;
+  const char *value_end = end;
+  while (value_end != value && isSpace(value_end[-1])) --value_end;
+  fields.emplace_back(std::piecewise_construct,
+                      std::forward_as_tuple(begin, colon),
+                      std::forward_as_tuple(value, value_end));
+}
+
+size_t Header::erase(const string &name) {
+  size_t size = fields.size();
+  fields.erase(std::remove_if(fields.begin(), fields.end(),
+                              [&](const Field &field) {
+                                return field.first.size() == name.size() &&
+                                       strcasecmp(field.first.c_str(),
+                                                  name.c_str()) == 0;
+                              }),
+               fields.end());
+  return size - fields.size();
+}
+
+void Http::to_json(json &j, const Header &header) {
+  j = json::object();
+  for (const auto &field : header) {
+    j[field.first] = field.second;
+  }
+}
+
+void Http::from_json(const json &j, Header &header) {
+  header.clear();
+  for (auto it = j.begin(); it != j.end(); ++it) {
+    header.add(it.key(), it.value().get<string>());
+  }
+}
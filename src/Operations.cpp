@@ -0,0 +1,458 @@
+#include "Operations.hpp"
+#include "Exceptions.hpp"
+#include "Utility.hpp"
+
+using namespace DockerClientpp;
+using namespace Http;
+
+void Operations::prepare(Request &request, const string &api_version) {
+  Header &header = request.header;
+  header.reserve(header.size() + 4);
+  if (header.find("Content-Type") == header.end()) {
+    header.add("Content-Type", "application/json");
+  }
+  if (header.find("Content-Length") == header.end()) {
+    header.add("Content-Length", std::to_string(request.body.size()));
+  }
+  if (header.find("Host") == header.end()) {
+    header.add("Host", api_version);
+  }
+  if (header.find("Accept") == header.end()) {
+    header.add("Accept", "*/*");
+  }
+}
+
+void Operations::checkStatus(const Request &request, const Response &response,
+                             std::initializer_list<int> accepted) {
+  for (int status_code : accepted) {
+    if (response.status_code == status_code) return;
+  }
+  json body = json::parse(response.body);
+  throw DockerOperationError(request.uri, response.status_code,
+                             body["message"].get<string>());
+}
+
+namespace {
+//  Decoders read only the fields they need straight from the body
+
+void decodeState(Utility::JsonScanner &scanner, ContainerState &state) {
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "Status") {
+      state.status = scanner.readString();
+    } else if (key == "Running") {
+      state.running = scanner.readBool();
+    } else if (key == "Paused") {
+      state.paused = scanner.readBool();
+    } else if (key == "Restarting") {
+      state.restarting = scanner.readBool();
+    } else if (key == "OOMKilled") {
+      state.oom_killed = scanner.readBool();
+    } else if (key == "Dead") {
+      state.dead = scanner.readBool();
+    } else if (key == "Pid") {
+      state.pid = scanner.readInteger();
+    } else if (key == "ExitCode") {
+      state.exit_code = scanner.readInteger();
+    } else if (key == "Error") {
+      state.error = scanner.readString();
+    } else if (key == "StartedAt") {
+      state.started_at = scanner.readString();
+    } else if (key == "FinishedAt") {
+      state.finished_at = scanner.readString();
+    } else {
+      scanner.skipValue();
+    }
+  }
+}
+
+void decodeCpu(Utility::JsonScanner &scanner, CpuUsage &cpu) {
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "cpu_usage") {
+      scanner.beginObject();
+      while (scanner.nextMember(key)) {
+        if (key == "total_usage") {
+          cpu.total_usage = scanner.readUnsigned();
+        } else {
+          scanner.skipValue();
+        }
+      }
+    } else if (key == "system_cpu_usage") {
+      cpu.system_usage = scanner.readUnsigned();
+    } else if (key == "online_cpus") {
+      cpu.online_cpus = scanner.readUnsigned();
+    } else {
+      scanner.skipValue();
+    }
+  }
+}
+}  // namespace
+
+Request Operations::ListImages::request() {
+  return {"GET", "/images/json", {}, {}, ""};
+}
+
+vector<string> Operations::ListImages::result(const Request &request,
+                                              Response &response) {
+  checkStatus(request, response, {200});
+  vector<string> names;
+  const string &text = response.body;
+  Utility::JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginArray();
+  while (scanner.nextElement()) {
+    scanner.beginObject();
+    while (scanner.nextMember(key)) {
+      if (key != "RepoTags") {
+        scanner.skipValue();
+        continue;
+      }
+      //  Dangling images have null RepoTags
+      if (scanner.readNull()) continue;
+      //  Prefer the "latest" tag, otherwise take the last one
+      string name;
+      bool done = false;
+      scanner.beginArray();
+      while (scanner.nextElement()) {
+        if (done) {
+          scanner.skipValue();
+          continue;
+        }
+        string tag_name = scanner.readString();
+        size_t pos = tag_name.find("latest");
+        if (pos != string::npos) {
+          name = tag_name.substr(0, pos - 1);
+          done = true;
+        } else {
+          name = std::move(tag_name);
+        }
+      }
+      if (!name.empty()) names.push_back(std::move(name));
+    }
+  }
+  return names;
+}
+
+Request Operations::GetRunningContainers::request() {
+  return {"GET", "/containers/json", {}, {}, ""};
+}
+
+vector<string> Operations::GetRunningContainers::result(
+    const Request &request, Response &response) {
+  checkStatus(request, response, {200});
+  vector<string> names;
+  const string &text = response.body;
+  Utility::JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginArray();
+  while (scanner.nextElement()) {
+    scanner.beginObject();
+    while (scanner.nextMember(key)) {
+      if (key != "Names") {
+        scanner.skipValue();
+        continue;
+      }
+      //  Names start with '/', the last one is reported
+      string name;
+      scanner.beginArray();
+      while (scanner.nextElement()) name = scanner.readString();
+      if (!name.empty()) names.push_back(name.substr(1));
+    }
+  }
+  return names;
+}
+
+Request Operations::CreateContainer::request(const json &config,
+                                             const string &name) {
+  QueryParam query_param{};
+  if (!name.empty()) {
+    query_param["name"] = name;
+  }
+  return {"POST", "/containers/create", {}, query_param, config.dump()};
+}
+
+string Operations::CreateContainer::result(const Request &request,
+                                           Response &response) {
+  checkStatus(request, response, {201});
+  return json::parse(response.body)["Id"];
+}
+
+Request Operations::StartContainer::request(const string &identifier) {
+  return {"POST", "/containers/" + identifier + "/start", {}, {}, ""};
+}
+
+void Operations::StartContainer::result(const Request &request,
+                                        Response &response) {
+  checkStatus(request, response, {204});
+}
+
+Request Operations::StopContainer::request(const string &identifier) {
+  return {"POST", "/containers/" + identifier + "/stop", {}, {}, ""};
+}
+
+void Operations::StopContainer::result(const Request &request,
+                                       Response &response) {
+  checkStatus(request, response, {204});
+}
+
+Request Operations::KillContainer::request(const string &identifier) {
+  return {"POST", "/containers/" + identifier + "/kill", {}, {}, ""};
+}
+
+void Operations::KillContainer::result(const Request &request,
+                                       Response &response) {
+  //  Killing a container that is already gone is not an error
+  checkStatus(request, response, {204, 404});
+}
+
+Request Operations::RemoveContainer::request(const string &identifier,
+                                             bool remove_volume, bool force,
+                                             bool remove_link) {
+  QueryParam query_param{{"v", std::to_string(remove_volume)},
+                         {"force", std::to_string(force)},
+                         {"link", std::to_string(remove_link)}};
+  return {"DELETE", "/containers/" + identifier, {}, query_param, ""};
+}
+
+void Operations::RemoveContainer::result(const Request &request,
+                                         Response &response) {
+  checkStatus(request, response, {204});
+}
+
+Request Operations::WaitContainer::request(const string &identifier,
+                                           const string &condition) {
+  return {"POST",
+          "/containers/" + identifier + "/wait",
+          {},
+          {{"condition", condition}},
+          ""};
+}
+
+int Operations::WaitContainer::result(const Request &request,
+                                      Response &response) {
+  checkStatus(request, response, {200, 404});
+  return json::parse(response.body)["StatusCode"];
+}
+
+Request Operations::InspectContainer::request(const string &identifier) {
+  return {"GET", "/containers/" + identifier + "/json", {}, {}, ""};
+}
+
+string Operations::InspectContainer::result(const Request &request,
+                                            Response &response) {
+  checkStatus(request, response, {200});
+  return std::move(response.body);
+}
+
+Request Operations::InspectContainerInfo::request(const string &identifier) {
+  return InspectContainer::request(identifier);
+}
+
+ContainerInfo Operations::InspectContainerInfo::result(
+    const Request &request, Response &response) {
+  checkStatus(request, response, {200});
+  ContainerInfo info;
+  const string &text = response.body;
+  Utility::JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "Id") {
+      info.id = scanner.readString();
+    } else if (key == "Name") {
+      info.name = scanner.readString();
+    } else if (key == "Image") {
+      info.image = scanner.readString();
+    } else if (key == "Created") {
+      info.created = scanner.readString();
+    } else if (key == "RestartCount") {
+      info.restart_count = scanner.readInteger();
+    } else if (key == "State") {
+      decodeState(scanner, info.state);
+    } else {
+      scanner.skipValue();
+    }
+  }
+  return info;
+}
+
+Request Operations::GetLongId::request(const string &name) {
+  return InspectContainer::request(name);
+}
+
+string Operations::GetLongId::result(const Request &request,
+                                     Response &response) {
+  checkStatus(request, response, {200});
+  return json::parse(response.body).at("Id");
+}
+
+Request Operations::UpdateContainer::request(const string &identifier,
+                                             const json &config) {
+  return {"POST", "/containers/" + identifier + "/update", {}, {},
+          config.dump()};
+}
+
+void Operations::UpdateContainer::result(const Request &request,
+                                         Response &response) {
+  checkStatus(request, response, {200});
+}
+
+Request Operations::GetContainerStats::request(const string &identifier) {
+  return {"GET",
+          "/containers/" + identifier + "/stats",
+          {},
+          {{"stream", "0"}},
+          ""};
+}
+
+string Operations::GetContainerStats::result(const Request &request,
+                                             Response &response) {
+  checkStatus(request, response, {200});
+  return std::move(response.body);
+}
+
+Request Operations::GetContainerStatsSample::request(
+    const string &identifier) {
+  return GetContainerStats::request(identifier);
+}
+
+StatsSample Operations::GetContainerStatsSample::result(
+    const Request &request, Response &response) {
+  checkStatus(request, response, {200});
+  StatsSample sample;
+  const string &text = response.body;
+  Utility::JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "read") {
+      sample.read = scanner.readString();
+    } else if (key == "cpu_stats") {
+      decodeCpu(scanner, sample.cpu);
+    } else if (key == "precpu_stats") {
+      decodeCpu(scanner, sample.precpu);
+    } else if (key == "memory_stats") {
+      scanner.beginObject();
+      while (scanner.nextMember(key)) {
+        if (key == "usage") {
+          sample.memory_usage = scanner.readUnsigned();
+        } else if (key == "limit") {
+          sample.memory_limit = scanner.readUnsigned();
+        } else {
+          scanner.skipValue();
+        }
+      }
+    } else if (key == "pids_stats") {
+      scanner.beginObject();
+      while (scanner.nextMember(key)) {
+        if (key == "current") {
+          sample.pids = scanner.readUnsigned();
+        } else {
+          scanner.skipValue();
+        }
+      }
+    } else if (key == "networks" && scanner.peek() == '{') {
+      //  One object per interface, totals are summed
+      string interface;
+      scanner.beginObject();
+      while (scanner.nextMember(interface)) {
+        scanner.beginObject();
+        while (scanner.nextMember(key)) {
+          if (key == "rx_bytes") {
+            sample.network_rx_bytes += scanner.readUnsigned();
+          } else if (key == "tx_bytes") {
+            sample.network_tx_bytes += scanner.readUnsigned();
+          } else {
+            scanner.skipValue();
+          }
+        }
+      }
+    } else {
+      scanner.skipValue();
+    }
+  }
+  return sample;
+}
+
+Request Operations::GetLogs::request(const string &identifier, bool std_out,
+                                     bool std_err, int tail) {
+  QueryParam query_param{{"stdout", std_out ? "1" : "0"},
+                         {"stderr", std_err ? "1" : "0"}};
+  if (tail != -1) {
+    query_param.emplace("tail", std::to_string(tail));
+  }
+  return {"GET", "/containers/" + identifier + "/logs", {}, query_param, ""};
+}
+
+string Operations::GetLogs::result(const Request &request,
+                                   Response &response) {
+  checkStatus(request, response, {200});
+  return std::move(response.body);
+}
+
+Request Operations::CreateExecution::request(const string &identifier,
+                                             const json &config) {
+  return {"POST", "/containers/" + identifier + "/exec", {}, {},
+          config.dump()};
+}
+
+string Operations::CreateExecution::result(const Request &request,
+                                           Response &response) {
+  checkStatus(request, response, {201});
+  return json::parse(response.body)["Id"];
+}
+
+Request Operations::StartExecution::request(const string &id,
+                                            const json &config) {
+  return {"POST", "/exec/" + id + "/start", {}, {}, config.dump()};
+}
+
+string Operations::StartExecution::result(const Request &request,
+                                          Response &response) {
+  checkStatus(request, response, {200});
+  return std::move(response.body);
+}
+
+Request Operations::InspectExecution::request(const string &id) {
+  return {"GET", "/exec/" + id + "/json", {}, {}, ""};
+}
+
+string Operations::InspectExecution::result(const Request &request,
+                                            Response &response) {
+  checkStatus(request, response, {200});
+  return std::move(response.body);
+}
+
+Request Operations::InspectExecutionInfo::request(const string &id) {
+  return InspectExecution::request(id);
+}
+
+ExecInfo Operations::InspectExecutionInfo::result(const Request &request,
+                                                  Response &response) {
+  checkStatus(request, response, {200});
+  ExecInfo info;
+  const string &text = response.body;
+  Utility::JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    if (key == "ID") {
+      info.id = scanner.readString();
+    } else if (key == "ContainerID") {
+      info.container_id = scanner.readString();
+    } else if (key == "Running") {
+      info.running = scanner.readBool();
+    } else if (key == "ExitCode") {
+      //  null until the command has finished
+      if (!scanner.readNull()) info.exit_code = scanner.readInteger();
+    } else if (key == "Pid") {
+      info.pid = scanner.readInteger();
+    } else {
+      scanner.skipValue();
+    }
+  }
+  return info;
+}
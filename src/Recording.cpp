@@ -0,0 +1,344 @@
+#include "Recording.hpp"
+#include "Exceptions.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace DockerClientpp {
+namespace {
+typedef std::chrono::steady_clock Clock;
+
+const char MAGIC[] = "DCPPREC1";
+const size_t MAGIC_SIZE = 8;
+
+enum RecordKind : uint8_t {
+  RECORD_CONNECTED = 1,
+  RECORD_SENT = 2,
+  RECORD_RECEIVED = 3,
+  RECORD_CLOSED = 4
+};
+
+void appendVarint(string &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+uint64_t readVarint(const string &in, size_t &pos) {
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (pos >= in.size()) {
+      throw ParseError("Truncated recording");
+    }
+    uint8_t byte = in[pos++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+  throw ParseError("Invalid varint in recording");
+}
+}  // namespace
+
+class Recorder::Impl {
+ public:
+  explicit Impl(const string &path);
+  ~Impl();
+  uint32_t connected();
+  void write(RecordKind kind, uint32_t connection, const char *data,
+             size_t size);
+  void flush();
+
+ private:
+  std::mutex mutex;
+  FILE *file;
+  uint32_t next_connection;
+  Clock::time_point start;
+  uint64_t last_time;
+  string record;
+};
+
+class Replayer::Impl {
+ public:
+  Impl(const string &path, double latency_scale);
+  uint32_t connect();
+  void send(uint32_t connection);
+  size_t receive(uint32_t connection, char *buffer, size_t size);
+  bool reusable(uint32_t connection);
+  void close(uint32_t connection);
+  size_t connections() const;
+
+ private:
+  struct Event {
+    RecordKind kind;
+    uint64_t time;  //  Microseconds since the recording started
+    size_t offset;  //  Payload position in data
+    size_t size;
+  };
+
+  struct Connection {
+    uint64_t connect_time = 0;
+    vector<Event> events;
+    //  Next event to replay and how much of it was received already
+    size_t cursor = 0;
+    size_t received = 0;
+    //  When the last replayed event happened, in the recording and now
+    uint64_t last_time = 0;
+    Clock::time_point last_real;
+    std::atomic<bool> closed{false};
+  };
+
+  Connection &at(uint32_t connection);
+  void skipSent(Connection &conn);
+
+  string data;
+  vector<unique_ptr<Connection>> recorded;
+  std::atomic<size_t> next_connection;
+  double latency_scale;
+  //  Lets close() interrupt a replayed delay
+  std::mutex mutex;
+  std::condition_variable wakeup;
+};
+}  // namespace DockerClientpp
+
+using namespace DockerClientpp;
+
+Recorder::Impl::Impl(const string &path)
+    : file(fopen(path.c_str(), "wb")),
+      next_connection(0),
+      start(Clock::now()),
+      last_time(0) {
+  if (file == nullptr) {
+    throw Exception("Cannot create recording " + path + ": " +
+                    strerror(errno));
+  }
+  if (fwrite(MAGIC, 1, MAGIC_SIZE, file) != MAGIC_SIZE) {
+    fclose(file);
+    throw Exception("Cannot write recording " + path);
+  }
+}
+
+Recorder::Impl::~Impl() {
+  fclose(file);
+}
+
+uint32_t Recorder::Impl::connected() {
+  uint32_t connection;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    connection = next_connection++;
+  }
+  write(RECORD_CONNECTED, connection, nullptr, 0);
+  return connection;
+}
+
+void Recorder::Impl::write(RecordKind kind, uint32_t connection,
+                           const char *data, size_t size) {
+  std::lock_guard<std::mutex> lock(mutex);
+  //  Times are taken under the lock so they never go back in the file
+  uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                     Clock::now() - start)
+                     .count();
+  record.clear();
+  record.push_back(static_cast<char>(kind));
+  appendVarint(record, connection);
+  appendVarint(record, now - last_time);
+  last_time = now;
+  if (kind == RECORD_SENT || kind == RECORD_RECEIVED) {
+    appendVarint(record, size);
+  }
+  if (fwrite(record.data(), 1, record.size(), file) != record.size() ||
+      (size != 0 && fwrite(data, 1, size, file) != size)) {
+    throw Exception("Write recording failed: " + string(strerror(errno)));
+  }
+}
+
+void Recorder::Impl::flush() {
+  std::lock_guard<std::mutex> lock(mutex);
+  fflush(file);
+}
+
+Replayer::Impl::Impl(const string &path, double latency_scale)
+    : next_connection(0), latency_scale(latency_scale) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw Exception("Cannot open recording " + path);
+  }
+  data.assign(std::istreambuf_iterator<char>(in),
+              std::istreambuf_iterator<char>());
+  if (data.compare(0, MAGIC_SIZE, MAGIC) != 0) {
+    throw ParseError(path + " is not a recording");
+  }
+  size_t pos = MAGIC_SIZE;
+  uint64_t time = 0;
+  while (pos < data.size()) {
+    RecordKind kind = static_cast<RecordKind>(data[pos++]);
+    uint64_t connection = readVarint(data, pos);
+    time += readVarint(data, pos);
+    if (kind == RECORD_CONNECTED) {
+      if (connection != recorded.size()) {
+        throw ParseError("Connections out of order in recording");
+      }
+      recorded.emplace_back(new Connection);
+      recorded.back()->connect_time = time;
+      continue;
+    }
+    if (connection >= recorded.size()) {
+      throw ParseError("Unknown connection in recording");
+    }
+    Event event{kind, time, pos, 0};
+    if (kind == RECORD_SENT || kind == RECORD_RECEIVED) {
+      event.size = readVarint(data, pos);
+      if (event.size > data.size() - pos) {
+        throw ParseError("Truncated recording");
+      }
+      event.offset = pos;
+      pos += event.size;
+    } else if (kind != RECORD_CLOSED) {
+      throw ParseError("Unknown record in recording");
+    }
+    recorded[connection]->events.push_back(event);
+  }
+}
+
+Replayer::Impl::Connection &Replayer::Impl::at(uint32_t connection) {
+  if (connection >= recorded.size()) {
+    throw SocketError("Unknown recorded connection");
+  }
+  return *recorded[connection];
+}
+
+void Replayer::Impl::skipSent(Connection &conn) {
+  while (conn.cursor < conn.events.size() &&
+         conn.events[conn.cursor].kind == RECORD_SENT) {
+    conn.last_time = conn.events[conn.cursor].time;
+    conn.cursor++;
+  }
+}
+
+uint32_t Replayer::Impl::connect() {
+  size_t connection = next_connection++;
+  if (connection >= recorded.size()) {
+    throw SocketError("No more connections in the recording");
+  }
+  Connection &conn = *recorded[connection];
+  conn.last_time = conn.connect_time;
+  conn.last_real = Clock::now();
+  return connection;
+}
+
+void Replayer::Impl::send(uint32_t connection) {
+  Connection &conn = at(connection);
+  //  However the request is split now, it stands for the recorded one
+  skipSent(conn);
+  conn.last_real = Clock::now();
+}
+
+size_t Replayer::Impl::receive(uint32_t connection, char *buffer,
+                               size_t size) {
+  Connection &conn = at(connection);
+  skipSent(conn);
+  if (conn.closed || conn.cursor == conn.events.size() ||
+      conn.events[conn.cursor].kind != RECORD_RECEIVED) {
+    return 0;
+  }
+  const Event &event = conn.events[conn.cursor];
+  if (conn.received == 0) {
+    std::chrono::microseconds delay(static_cast<long long>(
+        (event.time - conn.last_time) * latency_scale));
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeup.wait_until(lock, conn.last_real + delay,
+                      [&conn] { return conn.closed.load(); });
+    if (conn.closed) return 0;
+  }
+  size_t n = std::min(size, event.size - conn.received);
+  memcpy(buffer, data.data() + event.offset + conn.received, n);
+  conn.received += n;
+  if (conn.received == event.size && event.size != 0) {
+    conn.received = 0;
+    conn.cursor++;
+    conn.last_time = event.time;
+    conn.last_real = Clock::now();
+  }
+  return n;
+}
+
+bool Replayer::Impl::reusable(uint32_t connection) {
+  Connection &conn = at(connection);
+  return !conn.closed && conn.received == 0 &&
+         conn.cursor < conn.events.size() &&
+         conn.events[conn.cursor].kind == RECORD_SENT;
+}
+
+void Replayer::Impl::close(uint32_t connection) {
+  at(connection).closed = true;
+  std::lock_guard<std::mutex> lock(mutex);
+  wakeup.notify_all();
+}
+
+size_t Replayer::Impl::connections() const {
+  return recorded.size();
+}
+
+//-------------------------Recorder Implementation-------------------------//
+
+Recorder::Recorder(const string &path) : m_impl(new Impl(path)) {}
+
+Recorder::~Recorder() {}
+
+uint32_t Recorder::connected() {
+  return m_impl->connected();
+}
+
+void Recorder::sent(uint32_t connection, const char *data, size_t size) {
+  m_impl->write(RECORD_SENT, connection, data, size);
+}
+
+void Recorder::received(uint32_t connection, const char *data, size_t size) {
+  m_impl->write(RECORD_RECEIVED, connection, data, size);
+}
+
+void Recorder::closed(uint32_t connection) {
+  m_impl->write(RECORD_CLOSED, connection, nullptr, 0);
+}
+
+void Recorder::flush() {
+  m_impl->flush();
+}
+
+//-------------------------Replayer Implementation-------------------------//
+
+Replayer::Replayer(const string &path, double latency_scale)
+    : m_impl(new Impl(path, latency_scale)) {}
+
+Replayer::~Replayer() {}
+
+uint32_t Replayer::connect() {
+  return m_impl->connect();
+}
+
+void Replayer::send(uint32_t connection) {
+  m_impl->send(connection);
+}
+
+size_t Replayer::receive(uint32_t connection, char *buffer, size_t size) {
+  return m_impl->receive(connection, buffer, size);
+}
+
+bool Replayer::reusable(uint32_t connection) {
+  return m_impl->reusable(connection);
+}
+
+void Replayer::close(uint32_t connection) {
+  m_impl->close(connection);
+}
+
+size_t Replayer::connections() const {
+  return m_impl->connections();
+}
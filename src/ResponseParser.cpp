@@ -0,0 +1,178 @@
+#include "ResponseParser.hpp"
+#include "Exceptions.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <strings.h>
+
+using namespace DockerClientpp;
+using namespace Http;
+
+namespace {
+const size_t MAX_HEAD_SIZE = 64 * 1024;
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+bool equalsIgnoreCase(StringRef ref, const char *other) {
+  return strlen(other) == ref.size &&
+         strncasecmp(ref.data, other, ref.size) == 0;
+}
+}  // namespace
+
+ResponseParser::ResponseParser() {
+  reset();
+}
+
+void ResponseParser::reset() {
+  base = nullptr;
+  scanned = 0;
+  head_size = 0;
+  status_parsed = false;
+  status_code = 0;
+  fields.clear();
+  body_mode = UNTIL_EOF;
+  content_length = 0;
+  keep_alive = true;
+}
+
+bool ResponseParser::parseHead(const char *data, size_t size) {
+  base = data;
+  if (head_size != 0) return true;
+  while (true) {
+    size_t line_size = lineSize(data + scanned, size - scanned);
+    if (line_size == 0) {
+      if (size > MAX_HEAD_SIZE) {
+        throw ParseError("Http response header too large");
+      }
+      return false;
+    }
+    size_t begin = scanned;
+    size_t end = scanned + line_size - 2;
+    scanned += line_size;
+    if (!status_parsed) {
+      parseStatusLine(begin, end);
+    } else if (begin == end) {
+      head_size = scanned;
+      decideBodyMode();
+      return true;
+    } else {
+      parseField(begin, end);
+    }
+  }
+}
+
+void ResponseParser::parseStatusLine(size_t begin, size_t end) {
+  //  HTTP/1.x SP 3DIGIT SP reason
+  const char *line = base + begin;
+  size_t size = end - begin;
+  if (size < 12 || strncmp(line, "HTTP/", 5) != 0 || line[8] != ' ' ||
+      !isdigit(line[9]) || !isdigit(line[10]) || !isdigit(line[11])) {
+    throw ParseError("Parse http status line error, which is: " +
+                     string(line, size));
+  }
+  status_code =
+      (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+  //  HTTP/1.0 closes the connection unless told otherwise
+  keep_alive = strncmp(line + 5, "1.0", 3) != 0;
+  status_parsed = true;
+}
+
+void ResponseParser::parseField(size_t begin, size_t end) {
+  size_t colon = begin;
+  while (colon < end && base[colon] != ':') ++colon;
+  if (colon == end) {
+    throw ParseError("Parse http header error, which is: " +
+                     string(base + begin, end - begin));
+  }
+  size_t value = colon + 1;
+  while (value < end && isSpace(base[value])) ++value;
+  size_t value_end = end;
+  while (value_end > value && isSpace(base[value_end - 1])) --value_end;
+  fields.push_back({begin, colon - begin, value, value_end - value});
+}
+
+void ResponseParser::decideBodyMode() {
+  bool chunked = false;
+  bool has_length = false;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    StringRef name = fieldName(i);
+    StringRef value = fieldValue(i);
+    if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+      chunked = equalsIgnoreCase(value, "chunked");
+    } else if (equalsIgnoreCase(name, "Content-Length")) {
+      if (value.empty()) {
+        throw ParseError("Empty Content-Length");
+      }
+      content_length = 0;
+      for (size_t j = 0; j < value.size; ++j) {
+        if (!isdigit(value.data[j]) || content_length > SIZE_MAX / 10 - 1) {
+          throw ParseError("Invalid Content-Length: " + value.str());
+        }
+        content_length = content_length * 10 + (value.data[j] - '0');
+      }
+      has_length = true;
+    } else if (equalsIgnoreCase(name, "Connection")) {
+      if (equalsIgnoreCase(value, "close")) {
+        keep_alive = false;
+      } else if (equalsIgnoreCase(value, "keep-alive")) {
+        keep_alive = true;
+      }
+    }
+  }
+  if (status_code / 100 == 1 || status_code == 204 || status_code == 304) {
+    body_mode = NO_BODY;
+  } else if (chunked) {
+    body_mode = CHUNKED;
+  } else if (has_length) {
+    body_mode = CONTENT_LENGTH;
+  } else {
+    body_mode = UNTIL_EOF;
+    keep_alive = false;
+  }
+}
+
+StringRef ResponseParser::fieldName(size_t index) const {
+  return StringRef(base + fields[index].name, fields[index].name_size);
+}
+
+StringRef ResponseParser::fieldValue(size_t index) const {
+  return StringRef(base + fields[index].value, fields[index].value_size);
+}
+
+void ResponseParser::fillResponse(Response &response) const {
+  response.status_code = status_code;
+  response.header.reserve(response.header.size() + fields.size());
+  for (size_t i = 0; i < fields.size(); ++i) {
+    StringRef name = fieldName(i);
+    StringRef value = fieldValue(i);
+    response.header.add(name.str(), value.str());
+  }
+}
+
+size_t ResponseParser::lineSize(const char *data, size_t size) {
+  const char *lf = reinterpret_cast<const char *>(memchr(data, '\n', size));
+  if (lf == nullptr) return 0;
+  if (lf == data || lf[-1] != '\r') {
+    throw ParseError("Http line not ended by CRLF");
+  }
+  return lf - data + 1;
+}
+
+size_t ResponseParser::parseChunkSize(StringRef line) {
+  size_t size = 0;
+  size_t i = 0;
+  for (; i < line.size && isxdigit(line.data[i]); ++i) {
+    if (size > (SIZE_MAX >> 4)) {
+      throw ParseError("Chunk size too large");
+    }
+    char c = line.data[i];
+    size = size * 16 + (isdigit(c) ? c - '0' : (c | 0x20) - 'a' + 10);
+  }
+  if (i == 0) {
+    throw ParseError("Invalid chunk size line: " + line.str());
+  }
+  return size;
+}
@@ -1,10 +1,12 @@
 #include "SimpleHttpClient.hpp"
+#include "ResponseParser.hpp"
 #include "Socket.hpp"
 
 using namespace DockerClientpp::Http;
 // using namespace Http;
 using std::string;
 using std::shared_ptr;
+using std::vector;
 
 namespace DockerClientpp {
 namespace Http {
@@ -14,27 +16,73 @@ class SimpleHttpClient::Impl {
   ~Impl();
   shared_ptr<Response> Post(const Uri &uri, const Header &header,
                             const QueryParam &query_param,
-                            const std::string &data);
+                            const std::string &data,
+                            const ResponseHandler &handler);
   shared_ptr<Response> Put(const Uri &uri, const Header &header,
                            const QueryParam &query_param,
                            const std::string &data);
+  shared_ptr<Response> Put(const Uri &uri, const Header &header,
+                           const QueryParam &query_param,
+                           const BodyProducer &producer);
   shared_ptr<Response> Get(const Uri &uri, const Header &header,
-                           const QueryParam &query_param);
+                           const QueryParam &query_param,
+                           const ResponseHandler &handler);
   shared_ptr<Response> Delete(const Uri &uri, const Header &header,
                               const QueryParam &query_param);
+  vector<shared_ptr<Response>> Pipeline(const vector<Request> &requests);
 
- private:
-  string buildQuery(const Http::QueryParam &query_param);
-
-  std::shared_ptr<Response> sendAndRecieve(const string &req);
+  ResponseHandler streamHandler(const BodySink &sink,
+                                const HeadCallback &on_head = HeadCallback());
+  ResponseHandler multiplexedHandler(const FrameSink &sink);
 
-  void sendRequest(const string &req);
-  void getResponseHeader(std::shared_ptr<Response> &response);
+  void setKeepAlive(bool keep_alive);
+  void setTimeouts(const Timeouts &timeouts);
+  void setRecorder(const shared_ptr<Recorder> &recorder);
+  void setReplayer(const shared_ptr<Replayer> &replayer);
+  void shutdown();
+  ConnectionStats getConnectionStats() const;
 
-  int getStatusCode(const string &line);
+ private:
+  //  Only idempotent requests are sent again after a kept-alive
+  //  connection fails, the daemon may already have run the others
+  std::shared_ptr<Response> sendAndRecieve(
+      bool idempotent, const string &head, const string &body = string(),
+      const ResponseHandler &handler = ResponseHandler());
+  std::shared_ptr<Response> sendAndRecieve(
+      bool idempotent, const std::function<void()> &send_request,
+      const ResponseHandler &handler = ResponseHandler());
+  void readHead();
+  std::shared_ptr<Response> receiveResponse(const ResponseHandler &handler,
+                                            bool &reusable);
+  void readRawStream(BodyReader &reader, string &body);
+  void streamBody(Response &response, BodyReader &reader,
+                  const BodySink &sink);
+  static bool readFull(BodyReader &reader, char *buffer, size_t size);
+  static bool isRawStream(const Response &response);
+  static bool isIdempotent(const string &method);
+
+  typedef DeadlineScope::Clock Clock;
+  //  Start the total budget of a request, within the thread's scope
+  void startRequest();
+  //  Bound the next socket calls by a phase limit and the request budget
+  void startPhase(std::chrono::milliseconds limit);
+  void connect();
+  bool acquireConnection();
+  void sendRequest(const string &head, const string &body);
+  void sendChunked(const BodyProducer &producer);
 
  private:
   Socket socket;
+  //  Parses each response head in place in the socket buffer
+  ResponseParser parser;
+  bool keep_alive;
+  //  Set when a handler stops before the end of the body, the rest is
+  //  dropped with the connection instead of being read
+  bool body_abandoned;
+  ConnectionStats stats;
+  Timeouts timeouts;
+  //  When the current request has to be finished
+  Clock::time_point request_deadline;
 };
 }  // namespace Http
 }  // namespace DockerClientpp
@@ -42,29 +90,271 @@ class SimpleHttpClient::Impl {
 using std::cout;
 using std::endl;
 
-const int READ_BUFFER_SIZE = 256;
+namespace {
+/**
+ * @brief Reads a response body from the socket according to its framing
+ */
+class SocketBodyReader : public BodyReader {
+ public:
+  SocketBodyReader(DockerClientpp::Socket &socket,
+                   const ResponseParser &parser);
+  size_t read(char *buffer, size_t size) override;
+  size_t sizeHint() const override {
+    return mode == ResponseParser::CONTENT_LENGTH ? remaining : 0;
+  }
+
+  /**
+   * @brief Whether the end of the body is known without closing the
+   *        connection
+   */
+  bool delimited() const {
+    return mode != ResponseParser::UNTIL_EOF;
+  }
+  void drain();
+
+ private:
+  size_t readSome(char *buffer, size_t size);
+  DockerClientpp::StringRef nextLine();
+  void nextChunk();
+
+  DockerClientpp::Socket &socket;
+  ResponseParser::BodyMode mode;
+  size_t remaining;
+  bool first_chunk;
+  bool finished;
+};
+}  // namespace
+
+SocketBodyReader::SocketBodyReader(DockerClientpp::Socket &socket,
+                                   const ResponseParser &parser)
+    : socket(socket),
+      mode(parser.bodyMode()),
+      remaining(0),
+      first_chunk(true),
+      finished(false) {
+  if (mode == ResponseParser::CONTENT_LENGTH) {
+    remaining = parser.contentLength();
+  }
+  if (mode == ResponseParser::NO_BODY ||
+      (mode == ResponseParser::CONTENT_LENGTH && remaining == 0)) {
+    finished = true;
+  }
+}
+
+size_t SocketBodyReader::read(char *buffer, size_t size) {
+  if (finished || size == 0) return 0;
+  switch (mode) {
+    case ResponseParser::CONTENT_LENGTH: {
+      size_t read_d = readSome(buffer, std::min(size, remaining));
+      remaining -= read_d;
+      if (remaining == 0) finished = true;
+      return read_d;
+    }
+    case ResponseParser::CHUNKED: {
+      if (remaining == 0) {
+        nextChunk();
+        if (finished) return 0;
+      }
+      size_t read_d = readSome(buffer, std::min(size, remaining));
+      remaining -= read_d;
+      return read_d;
+    }
+    case ResponseParser::UNTIL_EOF: {
+      size_t read_d = socket.readSome(buffer, size);
+      if (read_d == 0) finished = true;
+      return read_d;
+    }
+    default:
+      return 0;
+  }
+}
+
+void SocketBodyReader::drain() {
+  char buffer[8192];
+  while (read(buffer, sizeof(buffer))) {
+  }
+}
+
+size_t SocketBodyReader::readSome(char *buffer, size_t size) {
+  size_t read_d = socket.readSome(buffer, size);
+  if (read_d == 0) {
+    //  Connection closed before the announced end of body
+    throw DockerClientpp::SocketEOFError(0);
+  }
+  return read_d;
+}
+
+DockerClientpp::StringRef SocketBodyReader::nextLine() {
+  //  Parsed in place, the line stays valid until the next socket read
+  DockerClientpp::StringRef data = socket.buffered();
+  size_t line_size;
+  while ((line_size = ResponseParser::lineSize(data.data, data.size)) == 0) {
+    if (socket.receiveMore() == 0) {
+      throw DockerClientpp::SocketEOFError(0);
+    }
+    data = socket.buffered();
+  }
+  socket.consume(line_size);
+  return DockerClientpp::StringRef(data.data, line_size - 2);
+}
+
+void SocketBodyReader::nextChunk() {
+  if (!first_chunk) {
+    //  CRLF after the previous chunk's data
+    nextLine();
+  }
+  first_chunk = false;
+  remaining = ResponseParser::parseChunkSize(nextLine());
+  if (remaining == 0) {
+    //  Last chunk, skip trailer fields up to the empty line
+    while (!nextLine().empty()) {
+    }
+    finished = true;
+  }
+}
+
+StreamDemuxer::StreamDemuxer(BodyReader &reader)
+    : reader(reader), remaining(0) {}
+
+bool StreamDemuxer::nextFrame(STREAM_TYPE &type, size_t &size) {
+  char skipped[4096];
+  while (remaining > 0) {
+    if (read(skipped, sizeof(skipped)) == 0) {
+      throw DockerClientpp::SocketEOFError(0);
+    }
+  }
+  unsigned char frame_header[8];
+  size_t total = 0;
+  while (total < sizeof(frame_header)) {
+    size_t read_d = reader.read(reinterpret_cast<char *>(frame_header) + total,
+                                sizeof(frame_header) - total);
+    if (read_d == 0) {
+      //  End of body between frames
+      if (total == 0) return false;
+      throw DockerClientpp::SocketEOFError(total);
+    }
+    total += read_d;
+  }
+  type = static_cast<STREAM_TYPE>(frame_header[0]);
+  size = (static_cast<size_t>(frame_header[4]) << 24) |
+         (static_cast<size_t>(frame_header[5]) << 16) |
+         (static_cast<size_t>(frame_header[6]) << 8) |
+         static_cast<size_t>(frame_header[7]);
+  remaining = size;
+  return true;
+}
+
+size_t StreamDemuxer::read(char *buffer, size_t size) {
+  if (remaining == 0 || size == 0) return 0;
+  size_t read_d = reader.read(buffer, std::min(size, remaining));
+  if (read_d == 0) {
+    throw DockerClientpp::SocketEOFError(0);
+  }
+  remaining -= read_d;
+  return read_d;
+}
+
+string BodyReader::readAll() {
+  const size_t MIN_READ_SIZE = 16 * 1024;
+  //  A known size is allocated exactly, an unknown one only once the body
+  //  turns out not to be empty
+  string result(sizeHint(), '\0');
+  size_t total = 0;
+  while (true) {
+    if (total == result.size()) {
+      //  Full, probe before growing so an exactly sized or empty body is not
+      //  given more room
+      char probe[4096];
+      size_t read_d = read(probe, sizeof(probe));
+      if (read_d == 0) break;
+      result.resize(std::max(result.size() * 2, MIN_READ_SIZE));
+      memcpy(&result[total], probe, read_d);
+      total += read_d;
+      continue;
+    }
+    size_t read_d = read(&result[total], result.size() - total);
+    if (read_d == 0) break;
+    total += read_d;
+  }
+  result.resize(total);
+  return result;
+}
+
+const size_t PIPELINE_DEPTH = 64;
+
+namespace {
+//  Deadline of the innermost DeadlineScope of each thread
+thread_local DeadlineScope::Clock::time_point scope_deadline =
+    DeadlineScope::Clock::time_point::max();
+}  // namespace
+
+DeadlineScope::DeadlineScope(std::chrono::milliseconds budget)
+    : previous(scope_deadline) {
+  if (budget.count() > 0) {
+    scope_deadline = std::min(scope_deadline, Clock::now() + budget);
+  }
+}
+
+DeadlineScope::DeadlineScope(Clock::time_point deadline)
+    : previous(scope_deadline) {
+  scope_deadline = std::min(scope_deadline, deadline);
+}
+
+DeadlineScope::~DeadlineScope() {
+  scope_deadline = previous;
+}
+
+DeadlineScope::Clock::time_point DeadlineScope::current() {
+  return scope_deadline;
+}
 
 SimpleHttpClient::Impl::Impl(const SOCK_TYPE type, const std::string &path)
-    : socket(type, path) {}
+    : socket(type, path),
+      keep_alive(true),
+      body_abandoned(false),
+      stats(),
+      request_deadline(Clock::time_point::max()) {}
 
 SimpleHttpClient::Impl::~Impl() {}
 
-shared_ptr<Response> SimpleHttpClient::Impl::Post(const Uri &uri,
-                                                  const Header &header,
-                                                  const QueryParam &query_param,
-                                                  const string &data) {
-  socket.connect();
+void SimpleHttpClient::Impl::setKeepAlive(bool keep_alive) {
+  this->keep_alive = keep_alive;
+  if (!keep_alive) socket.close();
+}
+
+void SimpleHttpClient::Impl::setTimeouts(const Timeouts &timeouts) {
+  this->timeouts = timeouts;
+}
+
+void SimpleHttpClient::Impl::setRecorder(const shared_ptr<Recorder> &recorder) {
+  socket.setRecorder(recorder);
+}
+
+void SimpleHttpClient::Impl::setReplayer(const shared_ptr<Replayer> &replayer) {
+  socket.setReplayer(replayer);
+}
+
+void SimpleHttpClient::Impl::shutdown() {
+  socket.shutdown();
+}
+
+ConnectionStats SimpleHttpClient::Impl::getConnectionStats() const {
+  return stats;
+}
+
+shared_ptr<Response> SimpleHttpClient::Impl::Post(
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const string &data, const ResponseHandler &handler) {
   //  build request text
   string sent_data("POST ");
-  string uri_with_query = uri + buildQuery(query_param);
+  string uri_with_query = uri + Utility::buildQuery(query_param);
   sent_data += uri_with_query;
   sent_data += " HTTP/1.1\r\n";
   sent_data += Utility::dumpHeader(header);
-  sent_data += data;
 
-  shared_ptr<Response> response = sendAndRecieve(sent_data);
+  //  Body is sent from the caller's buffer, never appended to the header
+  shared_ptr<Response> response = sendAndRecieve(false, sent_data, data, handler);
   response->uri = uri_with_query;
-  socket.close();
   return response;
 }
 
@@ -72,144 +362,403 @@ shared_ptr<Response> SimpleHttpClient::Impl::Put(const Uri &uri,
                                                  const Header &header,
                                                  const QueryParam &query_param,
                                                  const string &data) {
-  socket.connect();
   //  build request text
   string sent_data("PUT ");
-  string uri_with_query = uri + buildQuery(query_param);
+  string uri_with_query = uri + Utility::buildQuery(query_param);
   sent_data += uri_with_query;
   sent_data += " HTTP/1.1\r\n";
   sent_data += Utility::dumpHeader(header);
-  sent_data += data;
 
-  shared_ptr<Response> response = sendAndRecieve(sent_data);
+  //  Body is sent from the caller's buffer, never appended to the header
+  shared_ptr<Response> response = sendAndRecieve(true, sent_data, data);
+  response->uri = uri_with_query;
+  return response;
+}
+
+shared_ptr<Response> SimpleHttpClient::Impl::Put(
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const BodyProducer &producer) {
+  //  build request text
+  string sent_data("PUT ");
+  string uri_with_query = uri + Utility::buildQuery(query_param);
+  sent_data += uri_with_query;
+  sent_data += " HTTP/1.1\r\n";
+  sent_data += Utility::dumpHeader(header);
+
+  shared_ptr<Response> response = sendAndRecieve(true, [&] {
+    sendRequest(sent_data, string());
+    sendChunked(producer);
+  });
   response->uri = uri_with_query;
-  socket.close();
   return response;
 }
 
 shared_ptr<Response> SimpleHttpClient::Impl::Get(
-    const Uri &uri, const Header &header, const QueryParam &query_param) {
-  socket.connect();
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const ResponseHandler &handler) {
   //  build request text
   string sent_data("GET ");
-  string uri_with_query = uri + buildQuery(query_param);
+  string uri_with_query = uri + Utility::buildQuery(query_param);
   sent_data += uri_with_query;
   sent_data += " HTTP/1.1\r\n";
   sent_data += Utility::dumpHeader(header);
 
-  shared_ptr<Response> response = sendAndRecieve(sent_data);
+  shared_ptr<Response> response =
+      sendAndRecieve(
+      true, [&] { sendRequest(sent_data, string()); }, handler);
   response->uri = uri_with_query;
-  socket.close();
   return response;
 }
 
 shared_ptr<Response> SimpleHttpClient::Impl::Delete(
     const Uri &uri, const Header &header, const QueryParam &query_param) {
-  socket.connect();
   //  build request text
   string sent_data("DELETE ");
-  string uri_with_query = uri + buildQuery(query_param);
+  string uri_with_query = uri + Utility::buildQuery(query_param);
   sent_data += uri_with_query;
   sent_data += " HTTP/1.1\r\n";
   sent_data += Utility::dumpHeader(header);
 
-  shared_ptr<Response> response = sendAndRecieve(sent_data);
+  shared_ptr<Response> response = sendAndRecieve(true, sent_data);
   response->uri = uri_with_query;
-  socket.close();
   return response;
 }
 
-string SimpleHttpClient::Impl::buildQuery(const Http::QueryParam &query_param) {
-  string result;
-  if (!query_param.empty()) {
-    // TODO: parse special characters
-    result += "?";
-    for (auto it = query_param.begin(); it != query_param.end(); it++) {
-      result += it->first + "=" + it->second + "&";
+vector<shared_ptr<Response>> SimpleHttpClient::Impl::Pipeline(
+    const vector<Request> &requests) {
+  vector<shared_ptr<Response>> responses(requests.size());
+  vector<string> uris(requests.size());
+  vector<string> texts(requests.size());
+  for (size_t i = 0; i < requests.size(); i++) {
+    const Request &request = requests[i];
+    uris[i] = request.uri + Utility::buildQuery(request.query_param);
+    texts[i] = request.method + " " + uris[i] + " HTTP/1.1\r\n";
+    texts[i] += Utility::dumpHeader(request.header);
+    texts[i] += request.body;
+  }
+
+  //  Requests are written a window at a time, so neither side blocks on a
+  //  full socket buffer while the other one is writing too
+  const size_t depth = keep_alive ? PIPELINE_DEPTH : 1;
+  startRequest();
+  size_t answered = 0;
+  //  Requests before it were written at least once
+  size_t sent = 0;
+  bool retried = false;
+  while (answered < requests.size()) {
+    //  The daemon may have run what it did not answer, only requests that
+    //  can run twice are sent again
+    for (size_t i = answered; i < sent; i++) {
+      if (!isIdempotent(requests[i].method)) {
+        throw SocketError("Connection closed before " + requests[i].method +
+                          " " + uris[i] + " was answered");
+      }
     }
-    result.pop_back();
+    size_t begin = answered;
+    size_t end = std::min(begin + depth, requests.size());
+    bool reused = acquireConnection();
+    try {
+      string batch;
+      for (size_t i = begin; i < end; i++) {
+        batch += texts[i];
+      }
+      sent = std::max(sent, end);
+      startPhase(timeouts.write);
+      socket.write(batch);
+      bool reusable = true;
+      //  After a response that ends the connection, the requests left in
+      //  the window are sent again on a new one
+      while (answered < end && reusable) {
+        startPhase(timeouts.first_byte);
+        readHead();
+        startPhase(std::chrono::milliseconds(0));
+        responses[answered] = receiveResponse(ResponseHandler(), reusable);
+        responses[answered]->uri = uris[answered];
+        answered++;
+      }
+    } catch (TimeoutError &e) {
+      socket.close();
+      throw;
+    } catch (SocketError &e) {
+      socket.close();
+      //  A kept-alive connection may have gone stale before it answered
+      //  anything, one that did answer dropped in the middle of the window.
+      //  Either way the answers so far are kept and the rest is sent once
+      //  more, a fresh connection that answered nothing is not retried
+      if (retried || (!reused && answered == begin)) throw;
+      retried = true;
+      continue;
+    }
+    retried = false;
   }
-  return result;
+  return responses;
+}
+
+shared_ptr<Response> SimpleHttpClient::Impl::sendAndRecieve(
+    bool idempotent, const string &head, const string &body,
+    const ResponseHandler &handler) {
+  return sendAndRecieve(idempotent, [&] { sendRequest(head, body); },
+                        handler);
 }
 
 shared_ptr<Response> SimpleHttpClient::Impl::sendAndRecieve(
-    const string &sent_data) {
-  sendRequest(sent_data);
+    bool idempotent, const std::function<void()> &send_request,
+    const ResponseHandler &handler) {
+  startRequest();
+  bool reused = acquireConnection();
+  auto exchange = [&] {
+    startPhase(timeouts.write);
+    send_request();
+    startPhase(timeouts.first_byte);
+    readHead();
+  };
+
+  try {
+    try {
+      exchange();
+    } catch (TimeoutError &e) {
+      throw;
+    } catch (SocketError &e) {
+      //  The daemon most likely closed the idle connection before it saw
+      //  the request, but it may have run it and failed to answer. Only a
+      //  request that can run twice is sent again on a fresh connection
+      if (!reused || !idempotent) throw;
+      connect();
+      exchange();
+    }
+  } catch (SocketError &e) {
+    //  Whatever the daemon still sends for this request belongs to no one
+    socket.close();
+    throw;
+  }
+
+  startPhase(std::chrono::milliseconds(0));
+  bool reusable;
+  return receiveResponse(handler, reusable);
+}
+
+void SimpleHttpClient::Impl::readHead() {
+  //  Bytes of the head stay in the socket buffer until it is complete, so
+  //  the parser only looks at the lines each read completes
+  parser.reset();
+  try {
+    StringRef data = socket.buffered();
+    while (!parser.parseHead(data.data, data.size)) {
+      if (socket.receiveMore() == 0) {
+        throw SocketEOFError(data.size);
+      }
+      data = socket.buffered();
+    }
+  } catch (ParseError &e) {
+    socket.close();
+    throw;
+  }
+}
 
+shared_ptr<Response> SimpleHttpClient::Impl::receiveResponse(
+    const ResponseHandler &handler, bool &reusable) {
   shared_ptr<Response> response = std::make_shared<Response>();
-  getResponseHeader(response);
-
-  //  TODO: A better solution for skipping entity
-  if (response->status_code == 204) return response;
-
-  auto length_it = response->header.find("Content-Length");
-  auto end_it = response->header.end();
-  if (length_it != end_it) {
-    //  Read specific length of data
-    int length = std::stoi(length_it->get<std::string>());
-    response->body = socket.read(length);
-  } else if ((length_it = response->header.find("Transfer-Encoding")) !=
-                 end_it &&
-             *length_it == "chunked") {
-    //  Read according to chunked size
-    int chunk_size = 0;
-    do {
-      string line;
-      chunk_size = std::stoi(socket.readLine(line), nullptr, 16);
-      response->body += socket.read(chunk_size);
-      socket.readLine(line);
-    } while (chunk_size);
-  } else if ((length_it = response->header.find("Content-Type")) != end_it &&
-             *length_it == "application/vnd.docker.raw-stream") {
-    int chunk_size = 0;
-    while (true) {
-      //  Read stream according to docker stream protocol
-      //  https://docs.docker.com/engine/api/v1.24/#attach-to-a-container
-      //  response->chunk->push_back(Chunk{readFromSocket(1)[0], ""});
-      string line;
-      try {
-        socket.read(4);
-        chunk_size = __builtin_bswap32(
-            *reinterpret_cast<const unsigned int *>(socket.read(4).c_str()));
-      } catch (SocketError &e) {
-        break;
+  parser.fillResponse(*response);
+  socket.consume(parser.headSize());
+
+  SocketBodyReader reader(socket, parser);
+  //  Connection can only be reused if the end of the response is known
+  reusable = keep_alive && parser.keepAlive() && reader.delimited();
+
+  try {
+    if (handler) {
+      body_abandoned = false;
+      handler(*response, reader);
+      if (body_abandoned) {
+        reusable = false;
+      } else {
+        //  Skip whatever the handler left so the next response can be read
+        reader.drain();
       }
-      response->body += (socket.read(chunk_size));
+    } else if (isRawStream(*response)) {
+      readRawStream(reader, response->body);
+    } else {
+      response->body = reader.readAll();
     }
-  }  //  else {
-  //   throw NotImplementError("Cannot handle http response header without
-  //   Content-Length"
-  //                           " or Transfer-Encoding: chunked");
-  // }
+  } catch (...) {
+    socket.close();
+    throw;
+  }
+  if (!reusable) socket.close();
   return response;
 }
 
-void SimpleHttpClient::Impl::sendRequest(const string &req) {
-  socket.write(req);
+void SimpleHttpClient::Impl::readRawStream(BodyReader &reader, string &body) {
+  //  Read stream according to docker stream protocol
+  //  https://docs.docker.com/engine/api/v1.24/#attach-to-a-container
+  char frame_header[8];
+  while (true) {
+    //  Stream ends with the connection
+    if (!readFull(reader, frame_header, sizeof(frame_header))) break;
+    size_t chunk_size = __builtin_bswap32(
+        *reinterpret_cast<const unsigned int *>(frame_header + 4));
+    size_t offset = body.size();
+    body.resize(offset + chunk_size);
+    if (!readFull(reader, &body[offset], chunk_size)) {
+      throw DockerClientpp::SocketEOFError(0);
+    }
+  }
 }
 
-void SimpleHttpClient::Impl::getResponseHeader(shared_ptr<Response> &response) {
-  //  Read http response header from socket
-  // if (flag) {
-  //   string line = readFromSocket(1000);
-  //   cout << line << endl;
-  // }
-  string line;
-  socket.readLine(line);
-  response->status_code = getStatusCode(line);
-  line.clear();
-  while (not socket.readLine(line).empty()) {
-    auto pos = line.find(':');
-    if (pos == string::npos)
-      throw ParseError("Parse http header error, which is: " + line);
-    response->header[line.substr(0, pos)] = line.substr(pos + 2);
-    line.clear();
+bool SimpleHttpClient::Impl::readFull(BodyReader &reader, char *buffer,
+                                      size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    size_t read_d = reader.read(buffer + total, size - total);
+    if (read_d == 0) return false;
+    total += read_d;
   }
+  return true;
+}
+
+bool SimpleHttpClient::Impl::isIdempotent(const string &method) {
+  return method == "GET" || method == "HEAD" || method == "PUT" ||
+         method == "DELETE";
 }
 
-int SimpleHttpClient::Impl::getStatusCode(const string &line) {
-  auto pos = line.find(' ') + 1;
-  return std::stoi(line.substr(pos, 3));
+bool SimpleHttpClient::Impl::isRawStream(const Response &response) {
+  //  Hijacked connection carrying docker frames until it is closed
+  auto end_it = response.header.end();
+  auto type_it = response.header.find("Content-Type");
+  return type_it != end_it &&
+         type_it->second == "application/vnd.docker.raw-stream" &&
+         response.header.find("Content-Length") == end_it &&
+         response.header.find("Transfer-Encoding") == end_it;
+}
+
+ResponseHandler SimpleHttpClient::Impl::streamHandler(
+    const BodySink &sink, const HeadCallback &on_head) {
+  return [this, &sink, &on_head](Response &response, BodyReader &reader) {
+    if (on_head) on_head(response);
+    streamBody(response, reader, sink);
+  };
+}
+
+ResponseHandler SimpleHttpClient::Impl::multiplexedHandler(
+    const FrameSink &sink) {
+  return [this, &sink](Response &response, BodyReader &reader) {
+    if (response.status_code / 100 != 2) {
+      response.body = reader.readAll();
+      return;
+    }
+    StreamDemuxer demuxer(reader);
+    STREAM_TYPE type;
+    size_t size;
+    char buffer[16 * 1024];
+    while (demuxer.nextFrame(type, size)) {
+      size_t read_d;
+      while ((read_d = demuxer.read(buffer, sizeof(buffer))) > 0) {
+        if (!sink(type, buffer, read_d)) {
+          body_abandoned = true;
+          return;
+        }
+      }
+    }
+  };
+}
+
+void SimpleHttpClient::Impl::streamBody(Response &response, BodyReader &reader,
+                                        const BodySink &sink) {
+  //  Error bodies are kept so the caller can report them
+  if (response.status_code / 100 != 2) {
+    response.body = reader.readAll();
+    return;
+  }
+  char buffer[16 * 1024];
+  if (isRawStream(response)) {
+    char frame_header[8];
+    while (readFull(reader, frame_header, sizeof(frame_header))) {
+      size_t remaining = __builtin_bswap32(
+          *reinterpret_cast<const unsigned int *>(frame_header + 4));
+      while (remaining > 0) {
+        size_t read_d =
+            reader.read(buffer, std::min(sizeof(buffer), remaining));
+        if (read_d == 0) {
+          throw DockerClientpp::SocketEOFError(0);
+        }
+        remaining -= read_d;
+        if (!sink(buffer, read_d)) {
+          body_abandoned = true;
+          return;
+        }
+      }
+    }
+    return;
+  }
+  size_t read_d;
+  while ((read_d = reader.read(buffer, sizeof(buffer))) > 0) {
+    if (!sink(buffer, read_d)) {
+      body_abandoned = true;
+      return;
+    }
+  }
+}
+
+void SimpleHttpClient::Impl::startRequest() {
+  request_deadline = DeadlineScope::current();
+  if (timeouts.total.count() > 0) {
+    request_deadline = std::min(request_deadline, Clock::now() + timeouts.total);
+  }
+}
+
+void SimpleHttpClient::Impl::startPhase(std::chrono::milliseconds limit) {
+  Clock::time_point deadline = request_deadline;
+  if (limit.count() > 0) {
+    deadline = std::min(deadline, Clock::now() + limit);
+  }
+  socket.setDeadline(deadline);
+}
+
+void SimpleHttpClient::Impl::connect() {
+  startPhase(timeouts.connect);
+  socket.connect();
+  stats.fresh++;
+}
+
+bool SimpleHttpClient::Impl::acquireConnection() {
+  if (keep_alive && socket.isAlive()) {
+    stats.reused++;
+    return true;
+  }
+  connect();
+  return false;
+}
+
+void SimpleHttpClient::Impl::sendRequest(const string &head,
+                                         const string &body) {
+  if (body.empty()) {
+    socket.write(head);
+    return;
+  }
+  iovec iov[2];
+  iov[0].iov_base = const_cast<char *>(head.data());
+  iov[0].iov_len = head.size();
+  iov[1].iov_base = const_cast<char *>(body.data());
+  iov[1].iov_len = body.size();
+  socket.write(iov, 2);
+}
+
+void SimpleHttpClient::Impl::sendChunked(const BodyProducer &producer) {
+  producer([this](const char *data, size_t size) {
+    //  A zero sized chunk would end the body
+    if (size == 0) return;
+    char size_line[32];
+    int line_length = snprintf(size_line, sizeof(size_line), "%zx\r\n", size);
+    iovec iov[3];
+    iov[0].iov_base = size_line;
+    iov[0].iov_len = line_length;
+    iov[1].iov_base = const_cast<char *>(data);
+    iov[1].iov_len = size;
+    iov[2].iov_base = const_cast<char *>("\r\n");
+    iov[2].iov_len = 2;
+    socket.write(iov, 3);
+  });
+  socket.write("0\r\n\r\n", 5);
 }
 
 //-------------------------SimpleHttpClient
@@ -224,7 +773,7 @@ shared_ptr<Response> SimpleHttpClient::Post(const Uri &uri,
                                             const Header &header,
                                             const QueryParam &query_param,
                                             const string &data) {
-  return m_impl->Post(uri, header, query_param, data);
+  return m_impl->Post(uri, header, query_param, data, ResponseHandler());
 }
 
 shared_ptr<Response> SimpleHttpClient::Put(const Uri &uri, const Header &header,
@@ -233,9 +782,21 @@ shared_ptr<Response> SimpleHttpClient::Put(const Uri &uri, const Header &header,
   return m_impl->Put(uri, header, query_param, data);
 }
 
+shared_ptr<Response> SimpleHttpClient::Put(const Uri &uri, const Header &header,
+                                           const QueryParam &query_param,
+                                           const BodyProducer &producer) {
+  return m_impl->Put(uri, header, query_param, producer);
+}
+
 shared_ptr<Response> SimpleHttpClient::Get(const Uri &uri, const Header &header,
                                            const QueryParam &query_param) {
-  return m_impl->Get(uri, header, query_param);
+  return m_impl->Get(uri, header, query_param, ResponseHandler());
+}
+
+shared_ptr<Response> SimpleHttpClient::Get(const Uri &uri, const Header &header,
+                                           const QueryParam &query_param,
+                                           const ResponseHandler &handler) {
+  return m_impl->Get(uri, header, query_param, handler);
 }
 
 shared_ptr<Response> SimpleHttpClient::Delete(const Uri &uri,
@@ -243,3 +804,84 @@ shared_ptr<Response> SimpleHttpClient::Delete(const Uri &uri,
                                               const QueryParam &query_param) {
   return m_impl->Delete(uri, header, query_param);
 }
+
+shared_ptr<Response> SimpleHttpClient::GetStream(const Uri &uri,
+                                                 const Header &header,
+                                                 const QueryParam &query_param,
+                                                 const BodySink &sink,
+                                                 const HeadCallback &on_head) {
+  return m_impl->Get(uri, header, query_param,
+                     m_impl->streamHandler(sink, on_head));
+}
+
+shared_ptr<Response> SimpleHttpClient::PostStream(
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const string &data, const BodySink &sink) {
+  return m_impl->Post(uri, header, query_param, data,
+                      m_impl->streamHandler(sink));
+}
+
+shared_ptr<Response> SimpleHttpClient::Post(const Uri &uri,
+                                            const Header &header,
+                                            const QueryParam &query_param,
+                                            const string &data,
+                                            const ResponseHandler &handler) {
+  return m_impl->Post(uri, header, query_param, data, handler);
+}
+
+shared_ptr<Response> SimpleHttpClient::GetMultiplexed(
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const FrameSink &sink) {
+  return m_impl->Get(uri, header, query_param,
+                     m_impl->multiplexedHandler(sink));
+}
+
+shared_ptr<Response> SimpleHttpClient::PostMultiplexed(
+    const Uri &uri, const Header &header, const QueryParam &query_param,
+    const string &data, const FrameSink &sink) {
+  return m_impl->Post(uri, header, query_param, data,
+                      m_impl->multiplexedHandler(sink));
+}
+
+shared_ptr<Response> SimpleHttpClient::Send(const Request &request) {
+  if (request.method == "GET") {
+    return Get(request.uri, request.header, request.query_param);
+  } else if (request.method == "POST") {
+    return Post(request.uri, request.header, request.query_param,
+                request.body);
+  } else if (request.method == "PUT") {
+    return Put(request.uri, request.header, request.query_param, request.body);
+  } else if (request.method == "DELETE") {
+    return Delete(request.uri, request.header, request.query_param);
+  }
+  throw NotImplementError("Unsupported http method: " + request.method);
+}
+
+vector<shared_ptr<Response>> SimpleHttpClient::Pipeline(
+    const vector<Request> &requests) {
+  return m_impl->Pipeline(requests);
+}
+
+void SimpleHttpClient::setKeepAlive(bool keep_alive) {
+  m_impl->setKeepAlive(keep_alive);
+}
+
+void SimpleHttpClient::setTimeouts(const Timeouts &timeouts) {
+  m_impl->setTimeouts(timeouts);
+}
+
+void SimpleHttpClient::setRecorder(const shared_ptr<Recorder> &recorder) {
+  m_impl->setRecorder(recorder);
+}
+
+void SimpleHttpClient::setReplayer(const shared_ptr<Replayer> &replayer) {
+  m_impl->setReplayer(replayer);
+}
+
+void SimpleHttpClient::shutdown() {
+  m_impl->shutdown();
+}
+
+ConnectionStats SimpleHttpClient::getConnectionStats() const {
+  return m_impl->getConnectionStats();
+}
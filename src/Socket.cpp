@@ -1,5 +1,10 @@
 #include "Socket.hpp"
 
+#include <atomic>
+#include <climits>
+#include <mutex>
+#include <thread>
+
 using std::string;
 
 namespace DockerClientpp {
@@ -9,44 +14,74 @@ class Socket::Impl {
   ~Impl();
   void connect();
   void close();
+  void shutdown();
+  bool isAlive();
   void read(char *buffer, size_t size);
+  size_t readSome(char *buffer, size_t size);
   size_t readLine(char *buffer);
   const std::string &readLine(std::string &buffer);
+  StringRef buffered() const;
+  size_t receiveMore();
+  void consume(size_t size);
 
   void write(const char *buffer, size_t size);
+  void write(const iovec *iov, int count);
   void write(Utility::Archive &archive);
+  void setRecorder(const shared_ptr<Recorder> &recorder);
+  void setReplayer(const shared_ptr<Replayer> &replayer);
+  void setDeadline(Clock::time_point deadline);
 
  private:
-  int fd;
-  int addr_length;
-  char addr[64];
+  size_t fill();
+  //  Milliseconds left before the deadline, -1 without one. Throws
+  //  TimeoutError once it has passed
+  int remaining(const char *what) const;
+  //  Poll until the socket is ready for events or the deadline passes
+  void wait(short events, const char *what);
+  //  Every byte received goes through here, so it can be recorded or
+  //  replayed
+  size_t receive(char *buffer, size_t size);
+
+  //  Changed under close_mutex, atomic so the owning thread can read it
+  //  without taking the lock
+  std::atomic<int> fd;
+  socklen_t addr_length;
+  sockaddr_storage addr;
+
+  //  Read-ahead buffer shared by read() and readLine(), bytes in
+  //  [read_pos, read_end) are received but not consumed yet
+  std::vector<char> read_buffer;
+  size_t read_pos;
+  size_t read_end;
+
+  shared_ptr<Recorder> recorder;
+  shared_ptr<Replayer> replayer;
+  //  Number of the current connection in the recording, -1 when closed.
+  //  Changed under close_mutex like fd
+  std::atomic<long> connection;
+  //  Serializes close() with shutdown() from another thread, so shutdown()
+  //  never acts on a descriptor number that was closed and reused since
+  std::mutex close_mutex;
+  //  Set by shutdown(), later connects fail
+  bool shut_down;
+
+  Clock::time_point deadline;
 };
 }  // namespace DockerClientpp
 
 using namespace DockerClientpp;
 
-Socket::Impl::Impl(const SOCK_TYPE type, const string &path) : fd(-1) {
-  if (type == SOCK_UNIX) {
-    sockaddr_un server_socket_addr;
-    memset(&server_socket_addr, 0, sizeof(sockaddr_un));
-    server_socket_addr.sun_family = AF_UNIX;
-    strcpy(server_socket_addr.sun_path, path.c_str());
-    addr_length = offsetof(sockaddr_un, sun_path) +
-                  strlen(server_socket_addr.sun_path) + 1;
-    memcpy(&addr, &server_socket_addr, addr_length);
-  } else if (type == SOCK_TCP) {
-    //  TODO: URL support
-    sockaddr_in server_socket_addr;
+const size_t READ_BUFFER_SIZE = 16 * 1024;
 
-    auto seperate_position = path.find(':');
-    server_socket_addr.sin_port =
-        htons(std::stoi(path.substr(seperate_position + 1)));
-    server_socket_addr.sin_addr.s_addr =
-        inet_addr(path.substr(0, seperate_position).c_str());
-    server_socket_addr.sin_family = AF_INET;
-    addr_length = sizeof(server_socket_addr);
-    memcpy(&addr, &server_socket_addr, addr_length);
-  }
+Socket::Impl::Impl(const SOCK_TYPE type, const string &path)
+    : fd(-1),
+      read_buffer(READ_BUFFER_SIZE),
+      read_pos(0),
+      read_end(0),
+      connection(-1),
+      shut_down(false),
+      deadline(Clock::time_point::max()) {
+  addr_length = Socket::makeAddress(type, path, addr);
 
   // sockaddr *addr_ptr = reinterpret_cast<sockaddr *>(addr);
   // if ((fd = socket(addr_ptr->sa_family, SOCK_STREAM, 0)) < 0) {
@@ -63,113 +98,380 @@ Socket::Impl::~Impl() {
 }
 
 void Socket::Impl::connect() {
-  // this->close();
-  sockaddr *addr_ptr = reinterpret_cast<sockaddr *>(addr);
-  if ((fd = socket(addr_ptr->sa_family, SOCK_STREAM, 0)) < 0) {
+  this->close();
+  if (replayer) {
+    uint32_t replayed = replayer->connect();
+    std::lock_guard<std::mutex> lock(close_mutex);
+    if (shut_down) {
+      replayer->close(replayed);
+      throw SocketError("Socket was shut down");
+    }
+    connection = replayed;
+    return;
+  }
+  sockaddr *addr_ptr = reinterpret_cast<sockaddr *>(&addr);
+  int new_fd = socket(addr_ptr->sa_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (new_fd < 0) {
     throw SocketError(strerror(errno));
   }
-  if (::connect(fd, addr_ptr, addr_length) < 0) {
+  {
+    std::lock_guard<std::mutex> lock(close_mutex);
+    if (shut_down) {
+      ::close(new_fd);
+      throw SocketError("Socket was shut down");
+    }
+    fd = new_fd;
+  }
+  try {
+    int retry_ms = 1;
+    while (::connect(fd, addr_ptr, addr_length) < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        //  Backlog of a unix socket is full, nothing to poll for but the
+        //  connect can be tried again
+        int left = remaining("Connect timed out");
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+            left < 0 ? retry_ms : std::min(retry_ms, left)));
+        retry_ms = std::min(retry_ms * 2, 100);
+        continue;
+      }
+      if (errno != EINPROGRESS) throw SocketError(strerror(errno));
+      wait(POLLOUT, "Connect timed out");
+      int error = 0;
+      socklen_t length = sizeof(error);
+      if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0) {
+        error = errno;
+      }
+      if (error != 0) throw SocketError(strerror(error));
+      break;
+    }
+  } catch (...) {
+    this->close();
+    throw;
+  }
+  //  A shutdown() that came while the connection was being established
+  //  had nothing to act on yet
+  bool cancelled;
+  {
+    std::lock_guard<std::mutex> lock(close_mutex);
+    cancelled = shut_down;
+    if (!cancelled && recorder) connection = recorder->connected();
+  }
+  if (cancelled) {
     this->close();
-    throw SocketError(strerror(errno));
+    throw SocketError("Socket was shut down");
   }
 }
 
 void Socket::Impl::close() {
+  read_pos = read_end = 0;
+  std::lock_guard<std::mutex> lock(close_mutex);
+  if (replayer && connection >= 0) replayer->close(connection);
+  if (recorder && fd >= 0 && connection >= 0) recorder->closed(connection);
+  connection = -1;
+  if (fd < 0) return;
   ::close(fd);
+  fd = -1;
+}
+
+void Socket::Impl::shutdown() {
+  std::lock_guard<std::mutex> lock(close_mutex);
+  shut_down = true;
+  if (replayer && connection >= 0) {
+    replayer->close(connection);
+    return;
+  }
+  if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+}
+
+bool Socket::Impl::isAlive() {
+  //  Leftover bytes belong to no request
+  if (read_pos != read_end) return false;
+  if (replayer) {
+    return connection >= 0 && replayer->reusable(connection);
+  }
+  if (fd < 0) return false;
+  //  An idle keep-alive connection must not be readable: readable means
+  //  either the peer closed it (EOF) or it sent data nobody asked for
+  pollfd pfd{fd, POLLIN, 0};
+  int ret = ::poll(&pfd, 1, 0);
+  if (ret < 0) return false;
+  return ret == 0;
+}
+
+int Socket::Impl::remaining(const char *what) const {
+  if (deadline == Clock::time_point::max()) return -1;
+  auto left = std::chrono::duration_cast<std::chrono::microseconds>(
+      deadline - Clock::now());
+  if (left.count() <= 0) throw TimeoutError(what);
+  //  Rounded up so poll() does not return just before the deadline
+  return static_cast<int>(
+      std::min<long long>((left.count() + 999) / 1000, INT_MAX));
+}
+
+void Socket::Impl::wait(short events, const char *what) {
+  pollfd pfd{fd, events, 0};
+  while (true) {
+    int ret = ::poll(&pfd, 1, remaining(what));
+    if (ret > 0) return;
+    if (ret < 0 && errno != EINTR) throw SocketError(strerror(errno));
+    //  Timed out or interrupted, remaining() throws once the deadline passed
+  }
+}
+
+size_t Socket::Impl::fill() {
+  //  Only called when every buffered byte has been consumed
+  read_pos = read_end = 0;
+  read_end = receive(read_buffer.data(), read_buffer.size());
+  return read_end;
+}
+
+size_t Socket::Impl::receive(char *buffer, size_t size) {
+  if (replayer) {
+    if (connection < 0) throw SocketError("Socket is not connected");
+    return replayer->receive(connection, buffer, size);
+  }
+  ssize_t read_d;
+  while ((read_d = ::read(fd, buffer, size)) < 0) {
+    if (errno == EINTR) continue;
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      throw SocketError(strerror(errno));
+    }
+    wait(POLLIN, "Read timed out");
+  }
+  if (recorder && connection >= 0) {
+    recorder->received(connection, buffer, read_d);
+  }
+  return read_d;
 }
 
 void Socket::Impl::read(char *buffer, size_t size) {
-  ssize_t read_d = 0;
-  size_t total = 0;
+  size_t total = std::min(size, read_end - read_pos);
+  memcpy(buffer, read_buffer.data() + read_pos, total);
+  read_pos += total;
   while (total < size) {
-    read_d = ::read(fd, buffer + total, size - total);
-    if (read_d == 0) {
-      throw SocketEOFError(total);
+    size_t remain = size - total;
+    if (remain >= read_buffer.size()) {
+      //  Large reads bypass the buffer and go straight to the destination
+      size_t read_d = receive(buffer + total, remain);
+      if (read_d == 0) {
+        throw SocketEOFError(total);
+      }
+      total += read_d;
+    } else {
+      if (fill() == 0) {
+        throw SocketEOFError(total);
+      }
+      size_t n = std::min(remain, read_end);
+      memcpy(buffer + total, read_buffer.data(), n);
+      read_pos = n;
+      total += n;
     }
-    if (read_d < 0) {
-      throw SocketError(strerror(errno));
+  }
+}
+
+size_t Socket::Impl::readSome(char *buffer, size_t size) {
+  if (read_pos == read_end) {
+    if (size >= read_buffer.size()) {
+      return receive(buffer, size);
     }
-    total += read_d;
+    if (fill() == 0) return 0;
   }
+  size_t n = std::min(size, read_end - read_pos);
+  memcpy(buffer, read_buffer.data() + read_pos, n);
+  read_pos += n;
+  return n;
 }
 
 size_t Socket::Impl::readLine(char *buffer) {
-  int total = 0;
+  size_t total = 0;
   while (true) {
-    int read_d = ::read(fd, buffer + total, 1);
-    if (read_d == 0) {
+    if (read_pos == read_end && fill() == 0) {
       throw SocketEOFError(total);
     }
-    if (read_d < 0) {
-      throw SocketError(strerror(errno));
-    }
-    if (buffer[total] == '\r') {
-      total += read_d;
-      int read_d = ::read(fd, buffer + total, 1);
-      if (read_d == 0) {
-        throw SocketEOFError(total);
-      }
-      if (read_d < 0) {
-        throw SocketError(strerror(errno));
-      }
-      if (buffer[total] == '\n') {
-        buffer[total - 1] = 0;
-        return total - 1;
-      }
+    const char *begin = read_buffer.data() + read_pos;
+    size_t available = read_end - read_pos;
+    const char *lf =
+        reinterpret_cast<const char *>(memchr(begin, '\n', available));
+    size_t n = lf ? lf - begin + 1 : available;
+    memcpy(buffer + total, begin, n);
+    read_pos += n;
+    total += n;
+    if (lf && total >= 2 && buffer[total - 2] == '\r') {
+      total -= 2;
+      buffer[total] = 0;
+      return total;
     }
   }
 }
 
 const std::string &Socket::Impl::readLine(std::string &buffer) {
-  char ch;
+  size_t start = buffer.size();
   while (true) {
-    int read_d = ::read(fd, &ch, 1);
-    if (read_d == 0) {
+    if (read_pos == read_end && fill() == 0) {
       throw SocketEOFError(buffer.size());
     }
-    if (read_d < 0) {
-      throw SocketError(strerror(errno));
-    }
-    if (ch == '\r') {
-      char ch_2;
-      int read_d = ::read(fd, &ch_2, 1);
-      if (read_d == 0) {
-        throw SocketEOFError(buffer.size());
-      }
-      if (read_d < 0) {
-        throw SocketError(strerror(errno));
-      }
-      if (ch_2 == '\n') {
-        return buffer;
-      } else {
-        buffer += ch;
-        buffer += ch_2;
-      }
-    } else {
-      buffer += ch;
+    const char *begin = read_buffer.data() + read_pos;
+    size_t available = read_end - read_pos;
+    const char *lf =
+        reinterpret_cast<const char *>(memchr(begin, '\n', available));
+    size_t n = lf ? lf - begin + 1 : available;
+    buffer.append(begin, n);
+    read_pos += n;
+    if (lf && buffer.size() - start >= 2 &&
+        buffer[buffer.size() - 2] == '\r') {
+      buffer.resize(buffer.size() - 2);
+      return buffer;
     }
   }
 }
 
+StringRef Socket::Impl::buffered() const {
+  return StringRef(read_buffer.data() + read_pos, read_end - read_pos);
+}
+
+size_t Socket::Impl::receiveMore() {
+  //  Move what is left to the front, grow only when that is not enough
+  if (read_pos > 0) {
+    memmove(read_buffer.data(), read_buffer.data() + read_pos,
+            read_end - read_pos);
+    read_end -= read_pos;
+    read_pos = 0;
+  }
+  if (read_end == read_buffer.size()) {
+    read_buffer.resize(read_buffer.size() * 2);
+  }
+  size_t read_d = receive(read_buffer.data() + read_end,
+                          read_buffer.size() - read_end);
+  read_end += read_d;
+  return read_d;
+}
+
+void Socket::Impl::consume(size_t size) {
+  read_pos += std::min(size, read_end - read_pos);
+}
+
 void Socket::Impl::write(const char *buffer, size_t size) {
-  int written = 0;
-  size_t total_size = written;
-  //  cout << req << endl;
+  if (replayer) {
+    if (connection < 0) throw SocketError("Socket is not connected");
+    replayer->send(connection);
+    return;
+  }
+  if (recorder && connection >= 0 && size != 0) {
+    recorder->sent(connection, buffer, size);
+  }
+  size_t total_size = 0;
   while (total_size < size) {
-    written = ::write(fd, buffer + total_size, size - total_size);
+    ssize_t written =
+        ::send(fd, buffer + total_size, size - total_size, MSG_NOSIGNAL);
     if (written == -1) {
-      throw SocketError(strerror(errno));
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        throw SocketError(strerror(errno));
+      }
+      wait(POLLOUT, "Write timed out");
+      continue;
     }
     total_size += written;
   }
 }
 
+void Socket::Impl::write(const iovec *iov, int count) {
+  if (replayer) {
+    if (connection < 0) throw SocketError("Socket is not connected");
+    replayer->send(connection);
+    return;
+  }
+  if (recorder && connection >= 0) {
+    string gathered;
+    for (int i = 0; i < count; ++i) {
+      gathered.append(reinterpret_cast<const char *>(iov[i].iov_base),
+                      iov[i].iov_len);
+    }
+    if (!gathered.empty()) {
+      recorder->sent(connection, gathered.data(), gathered.size());
+    }
+  }
+  //  Local copy so partially sent buffers can be advanced
+  vector<iovec> pending(iov, iov + count);
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = pending.data();
+  msg.msg_iovlen = pending.size();
+  while (msg.msg_iovlen > 0) {
+    ssize_t written = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    if (written == -1) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        throw SocketError(strerror(errno));
+      }
+      wait(POLLOUT, "Write timed out");
+      continue;
+    }
+    while (msg.msg_iovlen > 0 &&
+           static_cast<size_t>(written) >= msg.msg_iov->iov_len) {
+      written -= msg.msg_iov->iov_len;
+      msg.msg_iov++;
+      msg.msg_iovlen--;
+    }
+    if (msg.msg_iovlen > 0) {
+      msg.msg_iov->iov_base =
+          reinterpret_cast<char *>(msg.msg_iov->iov_base) + written;
+      msg.msg_iov->iov_len -= written;
+    }
+  }
+}
+
 void Socket::Impl::write(Utility::Archive &archive) {
-  archive.writeToFd(fd);
+  //  Sent block by block through write() so deadlines and recording apply
+  //  to it too, writing to the non-blocking descriptor directly could fail
+  archive.writeTo(
+      [this](const char *data, size_t size) { write(data, size); });
+}
+
+void Socket::Impl::setRecorder(const shared_ptr<Recorder> &recorder) {
+  this->recorder = recorder;
+}
+
+void Socket::Impl::setReplayer(const shared_ptr<Replayer> &replayer) {
+  //  The current connection belongs to the previous mode
+  this->close();
+  this->replayer = replayer;
+}
+
+void Socket::Impl::setDeadline(Clock::time_point deadline) {
+  this->deadline = deadline;
 }
 
 //-------------------------Socket Implementation-------------------------//
 
+socklen_t Socket::makeAddress(const SOCK_TYPE type, const string &path,
+                              sockaddr_storage &addr) {
+  memset(&addr, 0, sizeof(addr));
+  if (type == SOCK_UNIX) {
+    sockaddr_un *server_socket_addr = reinterpret_cast<sockaddr_un *>(&addr);
+    if (path.size() >= sizeof(server_socket_addr->sun_path)) {
+      throw SocketError("Socket path too long: " + path);
+    }
+    server_socket_addr->sun_family = AF_UNIX;
+    strcpy(server_socket_addr->sun_path, path.c_str());
+    return offsetof(sockaddr_un, sun_path) +
+           strlen(server_socket_addr->sun_path) + 1;
+  } else if (type == SOCK_TCP) {
+    //  TODO: URL support
+    sockaddr_in *server_socket_addr = reinterpret_cast<sockaddr_in *>(&addr);
+
+    auto seperate_position = path.find(':');
+    server_socket_addr->sin_port =
+        htons(std::stoi(path.substr(seperate_position + 1)));
+    server_socket_addr->sin_addr.s_addr =
+        inet_addr(path.substr(0, seperate_position).c_str());
+    server_socket_addr->sin_family = AF_INET;
+    return sizeof(sockaddr_in);
+  }
+  throw SocketError("Unknown socket type");
+}
+
 Socket::Socket(const SOCK_TYPE type, const std::string &path)
     : m_impl(new Impl(type, path)) {}
 
@@ -183,21 +485,26 @@ void Socket::close() {
   m_impl->close();
 }
 
+void Socket::shutdown() {
+  m_impl->shutdown();
+}
+
+bool Socket::isAlive() {
+  return m_impl->isAlive();
+}
+
 void Socket::read(char *buffer, size_t size) {
   m_impl->read(buffer, size);
 }
 
+size_t Socket::readSome(char *buffer, size_t size) {
+  return m_impl->readSome(buffer, size);
+}
+
 std::string Socket::read(size_t size) {
-  std::string result;
-  const int BUFFER_SIZE = 256;
-  char buffer[BUFFER_SIZE];
-  while (size > BUFFER_SIZE) {
-    m_impl->read(buffer, BUFFER_SIZE);
-    result.append(buffer, BUFFER_SIZE);
-    size -= BUFFER_SIZE;
-  }
-  m_impl->read(buffer, size);
-  result.append(buffer, size);
+  //  Read straight into the result, large reads skip the read-ahead buffer
+  std::string result(size, '\0');
+  if (size > 0) m_impl->read(&result[0], size);
   return result;
 }
 
@@ -209,6 +516,18 @@ const std::string &Socket::readLine(std::string &buffer) {
   return m_impl->readLine(buffer);
 }
 
+StringRef Socket::buffered() const {
+  return m_impl->buffered();
+}
+
+size_t Socket::receiveMore() {
+  return m_impl->receiveMore();
+}
+
+void Socket::consume(size_t size) {
+  m_impl->consume(size);
+}
+
 void Socket::write(const char *content, size_t size) {
   m_impl->write(content, size);
 }
@@ -217,6 +536,22 @@ void Socket::write(const std::string &content) {
   m_impl->write(content.c_str(), content.size());
 }
 
+void Socket::write(const iovec *iov, int count) {
+  m_impl->write(iov, count);
+}
+
 void Socket::write(Utility::Archive &archive) {
   m_impl->write(archive);
 }
+
+void Socket::setRecorder(const shared_ptr<Recorder> &recorder) {
+  m_impl->setRecorder(recorder);
+}
+
+void Socket::setReplayer(const shared_ptr<Replayer> &replayer) {
+  m_impl->setReplayer(replayer);
+}
+
+void Socket::setDeadline(Clock::time_point deadline) {
+  m_impl->setDeadline(deadline);
+}
@@ -1,20 +1,57 @@
 #include "Utility.hpp"
 
+#include <cctype>
+#include <cstring>
+
 using namespace DockerClientpp;
 using std::string;
 
 string Utility::dumpHeader(const Header &header) {
+  size_t size = 2;
+  for (const auto &field : header) {
+    size += field.first.size() + field.second.size() + 4;
+  }
   string result;
-  for (auto it = header.begin(); it != header.end(); it++) {
-    result += it.key();
+  result.reserve(size);
+  for (const auto &field : header) {
+    result += field.first;
     result += ": ";
-    result += it.value().get<string>();
+    result += field.second;
     result += "\r\n";
   }
   result += "\r\n";
   return result;
 }
 
+string Utility::buildQuery(const QueryParam &query_param) {
+  string result;
+  if (!query_param.empty()) {
+    // TODO: parse special characters
+    result += "?";
+    for (auto it = query_param.begin(); it != query_param.end(); it++) {
+      result += it->first + "=" + it->second + "&";
+    }
+    result.pop_back();
+  }
+  return result;
+}
+
+string Utility::percentEncode(const string &value) {
+  static const char hex[] = "0123456789ABCDEF";
+  string result;
+  result.reserve(value.size());
+  for (unsigned char c : value) {
+    if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      result += c;
+    } else {
+      result += '%';
+      result += hex[c >> 4];
+      result += hex[c & 0xf];
+    }
+  }
+  return result;
+}
+
 Http::Header Utility::loadHeader(const string &header_str) {
   Http::Header header;
   std::stringstream ss(header_str);
@@ -22,10 +59,306 @@ Http::Header Utility::loadHeader(const string &header_str) {
   while (ss) {
     std::getline(ss, line);
     if (line.empty()) break;
-    auto pos = line.find(':');
-    if (pos == string::npos)
-      throw ParseError("Parse http header error, which is: " + line);
-    header[line.substr(0, pos)] = line.substr(pos + 2);
+    header.parseLine(line.data(), line.data() + line.size());
   }
   return header;
 }
+
+Utility::JsonScanner::JsonScanner(const char *begin, const char *end)
+    : begin(begin), pos(begin), end(end) {}
+
+char Utility::JsonScanner::peek() {
+  skipSpace();
+  if (pos == end) return 0;
+  switch (*pos) {
+    case '{':
+    case '[':
+    case '"':
+    case 't':
+    case 'f':
+      return *pos;
+    case 'n':
+      return 'N';
+    default:
+      return 'n';
+  }
+}
+
+void Utility::JsonScanner::beginObject() {
+  skipSpace();
+  expect('{');
+  started.push_back(false);
+}
+
+bool Utility::JsonScanner::nextMember(string &key) {
+  if (started.empty()) fail("not inside an object");
+  skipSpace();
+  if (pos < end && *pos == '}') {
+    pos++;
+    started.pop_back();
+    return false;
+  }
+  if (started.back()) {
+    expect(',');
+    skipSpace();
+  }
+  started.back() = true;
+  key = readString();
+  skipSpace();
+  expect(':');
+  return true;
+}
+
+void Utility::JsonScanner::beginArray() {
+  skipSpace();
+  expect('[');
+  started.push_back(false);
+}
+
+bool Utility::JsonScanner::nextElement() {
+  if (started.empty()) fail("not inside an array");
+  skipSpace();
+  if (pos < end && *pos == ']') {
+    pos++;
+    started.pop_back();
+    return false;
+  }
+  if (started.back()) {
+    expect(',');
+  }
+  started.back() = true;
+  return true;
+}
+
+string Utility::JsonScanner::readString() {
+  skipSpace();
+  expect('"');
+  string result;
+  while (true) {
+    const char *run = pos;
+    while (pos < end && *pos != '"' && *pos != '\\') pos++;
+    result.append(run, pos);
+    if (pos == end) fail("unterminated string");
+    if (*pos++ == '"') return result;
+    if (pos == end) fail("unterminated string");
+    char escaped = *pos++;
+    switch (escaped) {
+      case '"':
+      case '\\':
+      case '/':
+        result += escaped;
+        break;
+      case 'b':
+        result += '\b';
+        break;
+      case 'f':
+        result += '\f';
+        break;
+      case 'n':
+        result += '\n';
+        break;
+      case 'r':
+        result += '\r';
+        break;
+      case 't':
+        result += '\t';
+        break;
+      case 'u': {
+        auto hex4 = [this]() {
+          if (end - pos < 4) fail("bad unicode escape");
+          unsigned value = 0;
+          for (int i = 0; i < 4; i++) {
+            char c = *pos++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("bad unicode escape");
+          }
+          return value;
+        };
+        unsigned code = hex4();
+        if (code >= 0xD800 && code < 0xDC00 && end - pos >= 6 &&
+            pos[0] == '\\' && pos[1] == 'u') {
+          pos += 2;
+          unsigned low = hex4();
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        if (code < 0x80) {
+          result += static_cast<char>(code);
+        } else if (code < 0x800) {
+          result += static_cast<char>(0xC0 | (code >> 6));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+          result += static_cast<char>(0xE0 | (code >> 12));
+          result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+          result += static_cast<char>(0xF0 | (code >> 18));
+          result += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+          result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+          result += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        break;
+      }
+      default:
+        fail("bad escape");
+    }
+  }
+}
+
+int64_t Utility::JsonScanner::readInteger() {
+  char buffer[64];
+  bool integral = readNumber(buffer, sizeof(buffer));
+  if (!integral) return static_cast<int64_t>(strtod(buffer, nullptr));
+  return strtoll(buffer, nullptr, 10);
+}
+
+uint64_t Utility::JsonScanner::readUnsigned() {
+  char buffer[64];
+  bool integral = readNumber(buffer, sizeof(buffer));
+  if (buffer[0] == '-') return 0;
+  if (!integral) return static_cast<uint64_t>(strtod(buffer, nullptr));
+  return strtoull(buffer, nullptr, 10);
+}
+
+double Utility::JsonScanner::readDouble() {
+  char buffer[64];
+  readNumber(buffer, sizeof(buffer));
+  return strtod(buffer, nullptr);
+}
+
+bool Utility::JsonScanner::readBool() {
+  skipSpace();
+  if (end - pos >= 4 && memcmp(pos, "true", 4) == 0) {
+    pos += 4;
+    return true;
+  }
+  if (end - pos >= 5 && memcmp(pos, "false", 5) == 0) {
+    pos += 5;
+    return false;
+  }
+  fail("expected a boolean");
+}
+
+bool Utility::JsonScanner::readNull() {
+  skipSpace();
+  if (end - pos >= 4 && memcmp(pos, "null", 4) == 0) {
+    pos += 4;
+    return true;
+  }
+  return false;
+}
+
+void Utility::JsonScanner::skipValue() {
+  skipSpace();
+  if (pos == end) fail("unexpected end of input");
+  if (*pos == '"') {
+    skipString();
+  } else if (*pos == '{' || *pos == '[') {
+    //  Containers are skipped by bracket depth, strings may hold brackets
+    size_t depth = 0;
+    do {
+      if (pos == end) fail("unexpected end of input");
+      char c = *pos;
+      if (c == '"') {
+        skipString();
+        continue;
+      }
+      if (c == '{' || c == '[') depth++;
+      else if (c == '}' || c == ']') depth--;
+      pos++;
+    } while (depth > 0);
+  } else {
+    const char *value_end = numberEnd();
+    if (value_end == pos) fail("unexpected character");
+    pos = value_end;
+  }
+}
+
+void Utility::JsonScanner::skipSpace() {
+  while (pos < end &&
+         (*pos == ' ' || *pos == '\n' || *pos == '\r' || *pos == '\t'))
+    pos++;
+}
+
+void Utility::JsonScanner::expect(char c) {
+  if (pos == end || *pos != c) fail(string("expected '") + c + "'");
+  pos++;
+}
+
+void Utility::JsonScanner::skipString() {
+  pos++;
+  while (pos < end) {
+    const char *quote =
+        reinterpret_cast<const char *>(memchr(pos, '"', end - pos));
+    if (!quote) break;
+    //  A quote is escaped if an odd number of backslashes precede it
+    const char *backslash = quote;
+    while (backslash > pos && backslash[-1] == '\\') backslash--;
+    pos = quote + 1;
+    if ((quote - backslash) % 2 == 0) return;
+  }
+  fail("unterminated string");
+}
+
+bool Utility::JsonScanner::readNumber(char *buffer, size_t size) {
+  //  The input is not null terminated, copy the token for strto*()
+  skipSpace();
+  const char *number_end = numberEnd();
+  if (number_end == pos) fail("expected a number");
+  size_t length = std::min<size_t>(number_end - pos, size - 1);
+  memcpy(buffer, pos, length);
+  buffer[length] = 0;
+  pos = number_end;
+  return !strpbrk(buffer, ".eE");
+}
+
+const char *Utility::JsonScanner::numberEnd() {
+  //  Numbers and the literals true, false and null
+  const char *value_end = pos;
+  while (value_end < end && (isalnum(static_cast<unsigned char>(*value_end)) ||
+                             *value_end == '-' || *value_end == '+' ||
+                             *value_end == '.'))
+    value_end++;
+  return value_end;
+}
+
+void Utility::JsonScanner::fail(const string &what) {
+  throw ParseError("JSON scan error at offset " + std::to_string(pos - begin) +
+                   ": " + what);
+}
+
+bool Utility::JsonLineDecoder::feed(const char *data, size_t size,
+                                    const Callback &callback) {
+  const char *end = data + size;
+  while (data < end) {
+    const char *lf =
+        reinterpret_cast<const char *>(memchr(data, '\n', end - data));
+    if (!lf) {
+      pending.append(data, end);
+      break;
+    }
+    bool keep_going;
+    if (pending.empty()) {
+      //  Whole line is in the new data, parse it in place
+      keep_going = decode(data, lf, callback);
+    } else {
+      pending.append(data, lf);
+      keep_going = decode(pending.data(), pending.data() + pending.size(),
+                          callback);
+      pending.clear();
+    }
+    data = lf + 1;
+    if (!keep_going) return false;
+  }
+  return true;
+}
+
+bool Utility::JsonLineDecoder::decode(const char *begin, const char *end,
+                                      const Callback &callback) {
+  while (begin < end && isspace(static_cast<unsigned char>(*begin))) begin++;
+  while (end > begin && isspace(static_cast<unsigned char>(end[-1]))) end--;
+  if (begin == end) return true;
+  return callback(json::parse(begin, end));
+}
@@ -0,0 +1,114 @@
+#include "CoroDockerClient.hpp"
+
+using namespace DockerClientpp;
+using namespace Http;
+
+CoroDockerClient::CoroDockerClient(const SOCK_TYPE type, const string &path,
+                                   size_t max_connections)
+    : client(type, path, max_connections), api_version("v1.24") {}
+
+void CoroDockerClient::setAPIVersion(const string &api) {
+  api_version = api;
+}
+
+template <class Operation, class... Args>
+DockerAwaitable<typename Operation::Result> CoroDockerClient::call(
+    Args &&... args) {
+  Request request = Operation::request(std::forward<Args>(args)...);
+  Operations::prepare(request, api_version);
+  return DockerAwaitable<typename Operation::Result>(
+      client, std::move(request), &Operation::result);
+}
+
+DockerAwaitable<vector<string>> CoroDockerClient::listImages() {
+  return call<Operations::ListImages>();
+}
+
+DockerAwaitable<vector<string>> CoroDockerClient::getRunningContainers() {
+  return call<Operations::GetRunningContainers>();
+}
+
+DockerAwaitable<string> CoroDockerClient::createContainer(const json &config,
+                                                          const string &name) {
+  return call<Operations::CreateContainer>(config, name);
+}
+
+DockerAwaitable<void> CoroDockerClient::startContainer(
+    const string &identifier) {
+  return call<Operations::StartContainer>(identifier);
+}
+
+DockerAwaitable<void> CoroDockerClient::stopContainer(
+    const string &identifier) {
+  return call<Operations::StopContainer>(identifier);
+}
+
+DockerAwaitable<void> CoroDockerClient::killContainer(
+    const string &identifier) {
+  return call<Operations::KillContainer>(identifier);
+}
+
+DockerAwaitable<void> CoroDockerClient::removeContainer(
+    const string &identifier, bool remove_volume, bool force,
+    bool remove_link) {
+  return call<Operations::RemoveContainer>(identifier, remove_volume, force,
+                                           remove_link);
+}
+
+DockerAwaitable<int> CoroDockerClient::waitContainer(const string &identifier,
+                                                     const string &condition) {
+  return call<Operations::WaitContainer>(identifier, condition);
+}
+
+DockerAwaitable<string> CoroDockerClient::inspectContainer(
+    const string &identifier) {
+  return call<Operations::InspectContainer>(identifier);
+}
+
+DockerAwaitable<ContainerInfo> CoroDockerClient::inspectContainerInfo(
+    const string &identifier) {
+  return call<Operations::InspectContainerInfo>(identifier);
+}
+
+DockerAwaitable<string> CoroDockerClient::getLongId(const string &name) {
+  return call<Operations::GetLongId>(name);
+}
+
+DockerAwaitable<void> CoroDockerClient::updateContainer(
+    const string &identifier, const json &config) {
+  return call<Operations::UpdateContainer>(identifier, config);
+}
+
+DockerAwaitable<string> CoroDockerClient::getContainerStats(
+    const string &identifier) {
+  return call<Operations::GetContainerStats>(identifier);
+}
+
+DockerAwaitable<StatsSample> CoroDockerClient::getContainerStatsSample(
+    const string &identifier) {
+  return call<Operations::GetContainerStatsSample>(identifier);
+}
+
+DockerAwaitable<string> CoroDockerClient::getLogs(const string &identifier,
+                                                  bool std_out, bool std_err,
+                                                  int tail) {
+  return call<Operations::GetLogs>(identifier, std_out, std_err, tail);
+}
+
+DockerAwaitable<string> CoroDockerClient::createExecution(
+    const string &identifier, const json &config) {
+  return call<Operations::CreateExecution>(identifier, config);
+}
+
+DockerAwaitable<string> CoroDockerClient::inspectExecution(const string &id) {
+  return call<Operations::InspectExecution>(id);
+}
+
+DockerAwaitable<ExecInfo> CoroDockerClient::inspectExecutionInfo(
+    const string &id) {
+  return call<Operations::InspectExecutionInfo>(id);
+}
+
+ConnectionStats CoroDockerClient::getConnectionStats() const {
+  return client.getConnectionStats();
+}
@@ -1,10 +1,13 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <streambuf>
 
 #include "Archive.hpp"
+#include "Exceptions.hpp"
 #include "Socket.hpp"
 #include "gtest/gtest.h"
 
@@ -128,6 +131,39 @@ TEST(ArchiveTest, WriteToFdRecursiveTest) {
   std::remove("test.tar");
 }
 
+TEST(ArchiveTest, WriteToTest) {
+  std::fstream fs("1", std::fstream::out);
+  fs << 1 << std::endl;
+  fs.close();
+  fs.open("2", std::fstream::out);
+  fs << 2 << std::endl;
+  fs.close();
+
+  DockerClientpp::Utility::Archive ac;
+  ac.addFiles({"1", "2"});
+  std::fstream out_file("test.tar", std::fstream::out);
+  ac.writeTo([&out_file](const char *data, size_t size) {
+    out_file.write(data, size);
+  });
+  out_file.close();
+
+  std::remove("1");
+  std::remove("2");
+
+  std::system("tar axf test.tar");
+  std::fstream test_1("./1");
+  std::string content;
+  test_1 >> content;
+  EXPECT_EQ("1", content);
+  std::fstream test_2("./2");
+  test_2 >> content;
+  EXPECT_EQ("2", content);
+
+  std::remove("1");
+  std::remove("2");
+  std::remove("test.tar");
+}
+
 TEST(ArchiveTest, ExtractTest) {
   std::system("mkdir test_archive");
   std::system("echo 1 >> test_archive/1");
@@ -155,3 +191,90 @@ TEST(ArchiveTest, ExtractTest) {
 
   std::system("rm test test_archive.tar -r");
 }
+
+TEST(ArchiveTest, ExtractReaderTest) {
+  std::system("mkdir test_archive");
+  std::fstream fs("test_archive/1", std::fstream::out);
+  fs << 1 << std::endl;
+  fs.close();
+  //  Spans many reads of the reader below
+  std::string large(100 * 1000, 'x');
+  for (size_t i = 0; i < large.size(); i += 97) large[i] = 'a' + i % 26;
+  fs.open("test_archive/2", std::fstream::out);
+  fs << large;
+  fs.close();
+
+  DockerClientpp::Utility::Archive ac;
+  ac.addFile("test_archive");
+  std::string tar = ac.getTar();
+  std::system("rm -r test_archive");
+  std::system("mkdir test");
+
+  //  Short reads of a few bytes, like a body trickling in from a socket
+  size_t pos = 0;
+  size_t piece = 0;
+  DockerClientpp::Utility::Archive::extractTar(
+      [&](char *buffer, size_t size) {
+        piece = piece % 13 + 1;
+        size_t n = std::min({size, piece, tar.size() - pos});
+        std::copy(tar.data() + pos, tar.data() + pos + n, buffer);
+        pos += n;
+        return n;
+      },
+      "./test");
+  std::fstream test_1("./test/test_archive/1");
+  std::string content;
+  test_1 >> content;
+  EXPECT_EQ("1", content);
+  std::fstream test_2("./test/test_archive/2");
+  content.assign((std::istreambuf_iterator<char>(test_2)),
+                 std::istreambuf_iterator<char>());
+  EXPECT_EQ(large, content);
+
+  std::system("rm -r test");
+}
+
+namespace {
+struct ReaderFailure {};
+}  // namespace
+
+TEST(ArchiveTest, ExtractReaderErrorTest) {
+  std::fstream fs("1", std::fstream::out);
+  fs << 1 << std::endl;
+  fs.close();
+  DockerClientpp::Utility::Archive ac;
+  ac.addFile("1");
+  std::string tar = ac.getTar();
+  std::remove("1");
+  std::system("mkdir test");
+
+  //  The reader's own exception reaches the caller, not a ParseError
+  size_t pos = 0;
+  EXPECT_THROW(
+      DockerClientpp::Utility::Archive::extractTar(
+          [&](char *buffer, size_t size) -> size_t {
+            if (pos > 0) throw ReaderFailure();
+            size_t n = std::min<size_t>(size, 100);
+            std::copy(tar.data(), tar.data() + n, buffer);
+            pos += n;
+            return n;
+          },
+          "./test"),
+      ReaderFailure);
+
+  //  A stream that is no archive at all
+  std::string garbage(4096, 'g');
+  pos = 0;
+  EXPECT_THROW(DockerClientpp::Utility::Archive::extractTar(
+                   [&](char *buffer, size_t size) {
+                     size_t n = std::min(size, garbage.size() - pos);
+                     std::copy(garbage.data() + pos,
+                               garbage.data() + pos + n, buffer);
+                     pos += n;
+                     return n;
+                   },
+                   "./test"),
+               DockerClientpp::ParseError);
+
+  std::system("rm -r test");
+}
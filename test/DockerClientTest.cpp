@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <fstream>
+#include <thread>
 
+#include "AsyncDockerClient.hpp"
 #include "DockerClient.hpp"
 #include "gtest/gtest.h"
 
@@ -231,6 +233,46 @@ TEST(ExecTest, ExecCommandTest) {
   EXPECT_EQ("1\n", ret.output);
 }
 
+TEST(ExecTest, ExecCommandStreamsTest) {
+  DockerClient dc;
+  ExecRet ret =
+      dc.executeCommand("test", {"sh", "-c", "echo out; echo err >&2"});
+  EXPECT_EQ(0, ret.ret_code);
+  EXPECT_EQ("out\n", ret.std_out);
+  EXPECT_EQ("err\n", ret.std_err);
+  EXPECT_EQ(ret.std_out.size() + ret.std_err.size(), ret.output.size());
+}
+
+TEST(ExecTest, StreamStatsTest) {
+  DockerClient dc;
+  int samples = 0;
+  dc.streamContainerStats("test", [&samples](const json &sample) {
+    EXPECT_TRUE(sample.find("cpu_stats") != sample.end());
+    return ++samples < 3;
+  });
+  EXPECT_EQ(3, samples);
+}
+
+TEST(ExecTest, StreamLogsTest) {
+  std::system("docker rm -f testlogs > /dev/null 2>&1");
+  std::system(
+      "docker run -d --name testlogs busybox:1.26 "
+      "sh -c 'echo out; echo err >&2' > /dev/null 2>&1");
+  DockerClient dc;
+  dc.waitContainer("testlogs");
+  string out, err;
+  LogOptions options;
+  options.follow = true;
+  dc.streamLogs("testlogs", options,
+                [&out, &err](STREAM_TYPE type, const char *data, size_t size) {
+                  (type == STREAM_STDERR ? err : out).append(data, size);
+                  return true;
+                });
+  EXPECT_EQ("out\n", out);
+  EXPECT_EQ("err\n", err);
+  std::system("docker rm -f testlogs > /dev/null 2>&1");
+}
+
 TEST(ExecTest, PutFileTest) {
   DockerClient dc;  //(TCP, "127.0.0.1:8888");
   string id;
@@ -321,3 +363,122 @@ TEST(ExecTest, GetFileTest) {
   EXPECT_EQ("123", content);
   std::remove("1");
 }
+
+TEST(PoolTest, SharedClientTest) {
+  Http::PoolOptions options;
+  options.max_size = 4;
+  DockerClient dc(DockerClientpp::SOCK_UNIX, "/var/run/docker.sock", options);
+  const string long_id = dc.getLongId("test");
+  std::vector<std::thread> workers;
+  for (int i = 0; i < 16; i++) {
+    workers.emplace_back([&dc, &long_id] {
+      for (int j = 0; j < 10; j++) {
+        EXPECT_EQ(long_id, dc.getLongId("test"));
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+TEST(AsyncTest, ConcurrentInspectTest) {
+  DockerClient dc;
+  const string long_id = dc.getLongId("test");
+  AsyncDockerClient adc(DockerClientpp::SOCK_UNIX, "/var/run/docker.sock", 4);
+  std::vector<std::future<string>> ids;
+  for (int i = 0; i < 100; i++) {
+    ids.push_back(adc.getLongId("test"));
+  }
+  for (auto &id : ids) {
+    EXPECT_EQ(long_id, id.get());
+  }
+  EXPECT_LE(adc.getConnectionStats().fresh, 4u);
+  EXPECT_THROW(adc.inspectContainer("no-such-container").get(),
+               DockerOperationError);
+}
+
+TEST(BulkTest, InspectContainersTest) {
+  DockerClient dc;
+  const string info = dc.inspectContainer("test");
+  std::vector<string> ids(50, "test");
+  ids[10] = "no-such-container";
+  auto results = dc.inspectContainers(ids, 4);
+  ASSERT_EQ(ids.size(), results.size());
+  for (size_t i = 0; i < ids.size(); i++) {
+    EXPECT_EQ(ids[i], results[i].id);
+    if (i == 10) {
+      EXPECT_TRUE(results[i].error);
+      EXPECT_THROW(std::rethrow_exception(results[i].error),
+                   DockerOperationError);
+    } else {
+      EXPECT_FALSE(results[i].error);
+      EXPECT_EQ(json::parse(info)["Id"], json::parse(results[i].body)["Id"]);
+    }
+  }
+}
+
+TEST(EventTest, StreamEventsTest) {
+  DockerClient dc;
+  long since = time(nullptr);
+  std::system("docker restart test > /dev/null 2>&1");
+  EventOptions options;
+  options.since = since;
+  options.until = time(nullptr) + 1;
+  options.filters = {{"type", {"container"}}, {"container", {"test"}}};
+  std::vector<Event> events;
+  dc.streamEvents(options, [&events](const Event &event) {
+    events.push_back(event);
+    return true;
+  });
+  bool started = false;
+  for (const auto &event : events) {
+    EXPECT_EQ("container", event.type);
+    EXPECT_EQ("test", event.attributes.at("name"));
+    if (event.action == "start") started = true;
+  }
+  EXPECT_TRUE(started);
+}
+
+TEST(CacheTest, InspectCacheTest) {
+  DockerClient dc;
+  dc.enableInspectCache();
+  const string long_id = dc.getLongId("test");
+  EXPECT_EQ(long_id, dc.getLongId("test"));
+  EXPECT_TRUE(json::parse(dc.inspectContainer("test"))["State"]["Running"]
+                  .get<bool>());
+  std::system("docker stop test > /dev/null 2>&1");
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  EXPECT_FALSE(json::parse(dc.inspectContainer("test"))["State"]["Running"]
+                   .get<bool>());
+  EXPECT_FALSE(json::parse(dc.inspectContainer("test", true))["State"]
+                   ["Running"]
+                       .get<bool>());
+  std::system("docker start test > /dev/null 2>&1");
+  EXPECT_FALSE(dc.inspectCacheError());
+  dc.enableInspectCache(false);
+}
+
+TEST(TypedTest, TypedResultsTest) {
+  DockerClient dc;
+  json body = json::parse(dc.inspectContainer("test"));
+  ContainerInfo info = dc.inspectContainerInfo("test");
+  EXPECT_EQ(body["Id"].get<string>(), info.id);
+  EXPECT_EQ("/test", info.name);
+  EXPECT_EQ(body["State"]["Pid"].get<int>(), info.state.pid);
+  EXPECT_TRUE(info.state.running);
+
+  StatsSample sample = dc.getContainerStatsSample("test");
+  EXPECT_FALSE(sample.read.empty());
+  EXPECT_GT(sample.memory_usage, 0u);
+  EXPECT_GT(sample.pids, 0u);
+
+  string id = dc.createExecution(
+      "test", {{"AttachStdout", true}, {"Cmd", {"sh", "-c", "exit 3"}}});
+  EXPECT_FALSE(dc.inspectExecutionInfo(id).running);
+  dc.startExecution(id, {{"Detach", false}});
+  ExecInfo exec = dc.inspectExecutionInfo(id);
+  EXPECT_FALSE(exec.running);
+  EXPECT_EQ(3, exec.exit_code);
+  EXPECT_EQ(info.id, exec.container_id);
+}
@@ -0,0 +1,47 @@
+#include "Header.hpp"
+#include "Exceptions.hpp"
+#include "Utility.hpp"
+#include "gtest/gtest.h"
+
+using namespace DockerClientpp;
+
+TEST(HeaderTest, LookupTest) {
+  Http::Header header{{"Content-Type", "application/json"},
+                      {"Content-Length", "0"}};
+  ASSERT_NE(header.end(), header.find("content-length"));
+  EXPECT_EQ("0", header.find("CONTENT-LENGTH")->second);
+  EXPECT_EQ(header.end(), header.find("Content"));
+
+  header["content-length"] = "12";
+  EXPECT_EQ(2u, header.size());
+  EXPECT_EQ("12", header.find("Content-Length")->second);
+  header["Transfer-Encoding"] = "chunked";
+  EXPECT_EQ(1u, header.erase("content-length"));
+  EXPECT_EQ("Content-Type: application/json\r\n"
+            "Transfer-Encoding: chunked\r\n\r\n",
+            Utility::dumpHeader(header));
+}
+
+TEST(HeaderTest, ParseLineTest) {
+  Http::Header header;
+  const string lines[] = {"Content-Type: text/plain",
+                          "X-Empty:", "X-Spaces: \t padded \t"};
+  for (const auto &line : lines) {
+    header.parseLine(line.data(), line.data() + line.size());
+  }
+  EXPECT_EQ("text/plain", header.find("content-type")->second);
+  EXPECT_EQ("", header.find("X-Empty")->second);
+  EXPECT_EQ("padded", header.find("x-spaces")->second);
+  const string bad = "no colon";
+  EXPECT_THROW(header.parseLine(bad.data(), bad.data() + bad.size()),
+               ParseError);
+}
+
+TEST(HeaderTest, JsonTest) {
+  Http::Header header{{"Host", "v1.24"}, {"Accept", "*/*"}};
+  json j = header;
+  EXPECT_EQ("v1.24", j["Host"].get<string>());
+  Http::Header loaded = j;
+  EXPECT_EQ(2u, loaded.size());
+  EXPECT_EQ("*/*", loaded.find("accept")->second);
+}
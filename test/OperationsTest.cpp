@@ -0,0 +1,62 @@
+#include "Operations.hpp"
+#include "gtest/gtest.h"
+
+using namespace DockerClientpp;
+
+namespace {
+Http::Response makeResponse(const string &body) {
+  Http::Response response;
+  response.status_code = 200;
+  response.body = body;
+  return response;
+}
+}  // namespace
+
+TEST(OperationsTest, ListImagesTest) {
+  Http::Request request = Operations::ListImages::request();
+  Http::Response response = makeResponse(R"([
+    {"Id": "sha256:1", "RepoTags": ["busybox:1.26", "busybox:latest"],
+     "Labels": {"a": "b"}, "Size": 1093484},
+    {"Id": "sha256:2", "RepoTags": ["alpine:3.5", "alpine:3"]},
+    {"Id": "sha256:3", "RepoTags": null, "RepoDigests": ["x@sha256:3"]},
+    {"Id": "sha256:4", "RepoTags": []}
+  ])");
+  EXPECT_EQ(vector<string>({"busybox", "alpine:3"}),
+            Operations::ListImages::result(request, response));
+}
+
+TEST(OperationsTest, GetRunningContainersTest) {
+  Http::Request request = Operations::GetRunningContainers::request();
+  Http::Response response = makeResponse(R"([
+    {"Id": "1", "Names": ["/test"], "Ports": [{"PrivatePort": 80}],
+     "NetworkSettings": {"Networks": {"bridge": {"IPAddress": "x"}}}},
+    {"Id": "2", "Names": ["/other/link", "/second"]}
+  ])");
+  EXPECT_EQ(vector<string>({"test", "second"}),
+            Operations::GetRunningContainers::result(request, response));
+}
+
+TEST(OperationsTest, StatsSampleTest) {
+  Http::Request request = Operations::GetContainerStatsSample::request("test");
+  Http::Response response = makeResponse(R"({
+    "read": "2017-01-01T00:00:00Z", "pids_stats": {"current": 3},
+    "networks": {"eth0": {"rx_bytes": 10, "tx_bytes": 1},
+                 "eth1": {"rx_bytes": 5, "tx_bytes": 2}},
+    "memory_stats": {"usage": 4096, "limit": 8192, "stats": {"rss": 1}},
+    "cpu_stats": {"cpu_usage": {"total_usage": 100, "percpu_usage": [50, 50]},
+                  "system_cpu_usage": 1000, "online_cpus": 2},
+    "precpu_stats": {"cpu_usage": {"total_usage": 90}}
+  })");
+  StatsSample sample =
+      Operations::GetContainerStatsSample::result(request, response);
+  EXPECT_EQ("2017-01-01T00:00:00Z", sample.read);
+  EXPECT_EQ(3u, sample.pids);
+  EXPECT_EQ(15u, sample.network_rx_bytes);
+  EXPECT_EQ(3u, sample.network_tx_bytes);
+  EXPECT_EQ(4096u, sample.memory_usage);
+  EXPECT_EQ(8192u, sample.memory_limit);
+  EXPECT_EQ(100u, sample.cpu.total_usage);
+  EXPECT_EQ(1000u, sample.cpu.system_usage);
+  EXPECT_EQ(2u, sample.cpu.online_cpus);
+  EXPECT_EQ(90u, sample.precpu.total_usage);
+}
@@ -0,0 +1,142 @@
+#include "Recording.hpp"
+#include "Exceptions.hpp"
+#include "SimpleHttpClient.hpp"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+using namespace DockerClientpp;
+
+namespace {
+const char *RECORDING = "test.recording";
+
+const string RESPONSE_1 =
+    "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nfirst";
+const string RESPONSE_2 =
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+    "6\r\nsecond\r\n0\r\n\r\n";
+
+/**
+ * @brief Record two requests on one kept-alive connection, the second
+ *        response split in two blocks, then a closed connection
+ */
+void recordExchange(std::chrono::milliseconds delay) {
+  Recorder recorder(RECORDING);
+  uint32_t first = recorder.connected();
+  recorder.sent(first, "GET /1", 6);
+  std::this_thread::sleep_for(delay);
+  recorder.received(first, RESPONSE_1.data(), RESPONSE_1.size());
+  recorder.sent(first, "GET /2", 6);
+  recorder.received(first, RESPONSE_2.data(), 20);
+  recorder.received(first, RESPONSE_2.data() + 20, RESPONSE_2.size() - 20);
+  recorder.closed(first);
+  uint32_t second = recorder.connected();
+  recorder.sent(second, "GET /3", 6);
+  recorder.received(second, nullptr, 0);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+TEST(RecordingTest, ReplayerTest) {
+  recordExchange(std::chrono::milliseconds(0));
+  Replayer replayer(RECORDING, 0);
+  EXPECT_EQ(2u, replayer.connections());
+
+  uint32_t connection = replayer.connect();
+  EXPECT_EQ(0u, connection);
+  replayer.send(connection);
+  char buffer[64];
+  size_t n = replayer.receive(connection, buffer, 10);
+  EXPECT_EQ(RESPONSE_1.substr(0, 10), string(buffer, n));
+  n = replayer.receive(connection, buffer, sizeof(buffer));
+  EXPECT_EQ(RESPONSE_1.substr(10), string(buffer, n));
+  EXPECT_TRUE(replayer.reusable(connection));
+
+  replayer.send(connection);
+  string received;
+  while ((n = replayer.receive(connection, buffer, sizeof(buffer))) != 0) {
+    received.append(buffer, n);
+  }
+  EXPECT_EQ(RESPONSE_2, received);
+  EXPECT_FALSE(replayer.reusable(connection));
+
+  connection = replayer.connect();
+  replayer.send(connection);
+  EXPECT_EQ(0u, replayer.receive(connection, buffer, sizeof(buffer)));
+  EXPECT_THROW(replayer.connect(), SocketError);
+  std::remove(RECORDING);
+}
+
+TEST(RecordingTest, LatencyScaleTest) {
+  recordExchange(std::chrono::milliseconds(100));
+  char buffer[64];
+  for (double scale : {0.0, 1.0}) {
+    Replayer replayer(RECORDING, scale);
+    uint32_t connection = replayer.connect();
+    replayer.send(connection);
+    auto start = std::chrono::steady_clock::now();
+    replayer.receive(connection, buffer, sizeof(buffer));
+    if (scale == 0) {
+      EXPECT_GT(50, elapsedMs(start));
+    } else {
+      EXPECT_LE(90, elapsedMs(start));
+    }
+  }
+
+  //  Closing from another thread cuts a replayed delay short
+  Replayer replayer(RECORDING, 100);
+  uint32_t connection = replayer.connect();
+  replayer.send(connection);
+  auto start = std::chrono::steady_clock::now();
+  std::thread closer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    replayer.close(connection);
+  });
+  EXPECT_EQ(0u, replayer.receive(connection, buffer, sizeof(buffer)));
+  closer.join();
+  EXPECT_GT(5000, elapsedMs(start));
+  std::remove(RECORDING);
+}
+
+TEST(RecordingTest, SimpleHttpClientReplayTest) {
+  recordExchange(std::chrono::milliseconds(0));
+  //  No daemon listens there, every byte comes from the recording
+  Http::SimpleHttpClient client(SOCK_UNIX, "/nonexistent.sock");
+  client.setReplayer(std::make_shared<Replayer>(RECORDING, 0));
+
+  auto res = client.Get("/1", {}, {});
+  EXPECT_EQ(200, res->status_code);
+  EXPECT_EQ("first", res->body);
+  res = client.Get("/2", {}, {});
+  EXPECT_EQ("second", res->body);
+  Http::ConnectionStats stats = client.getConnectionStats();
+  EXPECT_EQ(1u, stats.fresh);
+  EXPECT_EQ(1u, stats.reused);
+
+  //  The recorded client opened a new connection, so does this one
+  EXPECT_THROW(client.Get("/3", {}, {}), Exception);
+  std::remove(RECORDING);
+}
+
+TEST(RecordingTest, CorruptRecordingTest) {
+  recordExchange(std::chrono::milliseconds(0));
+  std::ifstream in(RECORDING, std::ios::binary);
+  string data((std::istreambuf_iterator<char>(in)),
+              std::istreambuf_iterator<char>());
+  in.close();
+
+  std::ofstream(RECORDING, std::ios::binary) << data.substr(0, data.size() - 3);
+  EXPECT_THROW(Replayer(RECORDING, 0), ParseError);
+  std::ofstream(RECORDING, std::ios::binary) << "not a recording";
+  EXPECT_THROW(Replayer(RECORDING, 0), ParseError);
+  std::remove(RECORDING);
+  EXPECT_THROW(Replayer(RECORDING, 0), Exception);
+}
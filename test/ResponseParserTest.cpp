@@ -0,0 +1,87 @@
+#include "Exceptions.hpp"
+#include "ResponseParser.hpp"
+#include "gtest/gtest.h"
+
+using namespace DockerClientpp;
+using Http::ResponseParser;
+
+TEST(ResponseParserTest, PartialHeadTest) {
+  const string head =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: application/json\r\n"
+      "content-length:  42 \r\n"
+      "\r\n"
+      "{\"body\"";
+  ResponseParser parser;
+  //  Bytes arrive one at a time into a buffer that moves while it grows
+  string buffer;
+  size_t i = 0;
+  bool done = false;
+  while (!done && i < head.size()) {
+    buffer.push_back(head[i++]);
+    buffer.shrink_to_fit();
+    done = parser.parseHead(buffer.data(), buffer.size());
+  }
+  ASSERT_TRUE(done);
+  EXPECT_EQ(head.find('{'), parser.headSize());
+  EXPECT_EQ(200, parser.statusCode());
+  EXPECT_EQ(ResponseParser::CONTENT_LENGTH, parser.bodyMode());
+  EXPECT_EQ(42u, parser.contentLength());
+  EXPECT_TRUE(parser.keepAlive());
+  ASSERT_EQ(2u, parser.fieldCount());
+  EXPECT_TRUE(parser.fieldName(1) == "content-length");
+  EXPECT_TRUE(parser.fieldValue(1) == "42");
+
+  Http::Response response;
+  parser.fillResponse(response);
+  EXPECT_EQ(200, response.status_code);
+  EXPECT_EQ("application/json", response.header.find("Content-Type")->second);
+}
+
+TEST(ResponseParserTest, BodyModeTest) {
+  ResponseParser parser;
+  string head =
+      "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n"
+      "Content-Length: 3\r\n\r\n";
+  ASSERT_TRUE(parser.parseHead(head.data(), head.size()));
+  EXPECT_EQ(ResponseParser::CHUNKED, parser.bodyMode());
+
+  parser.reset();
+  head = "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+  ASSERT_TRUE(parser.parseHead(head.data(), head.size()));
+  EXPECT_EQ(ResponseParser::NO_BODY, parser.bodyMode());
+  EXPECT_FALSE(parser.keepAlive());
+
+  parser.reset();
+  head = "HTTP/1.1 200 OK\r\nContent-Type: application/x-tar\r\n\r\n";
+  ASSERT_TRUE(parser.parseHead(head.data(), head.size()));
+  EXPECT_EQ(ResponseParser::UNTIL_EOF, parser.bodyMode());
+  EXPECT_FALSE(parser.keepAlive());
+}
+
+TEST(ResponseParserTest, MalformedTest) {
+  ResponseParser parser;
+  string head = "HTTP/1.1 2x0 OK\r\n\r\n";
+  EXPECT_THROW(parser.parseHead(head.data(), head.size()), ParseError);
+  parser.reset();
+  head = "HTTP/1.1 200 OK\r\nno colon\r\n\r\n";
+  EXPECT_THROW(parser.parseHead(head.data(), head.size()), ParseError);
+  parser.reset();
+  head = "HTTP/1.1 200 OK\r\nContent-Length: 1x\r\n\r\n";
+  EXPECT_THROW(parser.parseHead(head.data(), head.size()), ParseError);
+  parser.reset();
+  head = "HTTP/1.1 200 OK\r\nX: " + string(70000, 'a');
+  EXPECT_THROW(parser.parseHead(head.data(), head.size()), ParseError);
+}
+
+TEST(ResponseParserTest, ChunkSizeTest) {
+  const string lines = "1a;name=value\r\n0\r\n";
+  EXPECT_EQ(0u, ResponseParser::lineSize(lines.data(), 5));
+  size_t size = ResponseParser::lineSize(lines.data(), lines.size());
+  EXPECT_EQ(15u, size);
+  EXPECT_EQ(26u, ResponseParser::parseChunkSize(StringRef(lines.data(), size)));
+  EXPECT_EQ(0u, ResponseParser::parseChunkSize(
+                    StringRef(lines.data() + size, lines.size() - size)));
+  EXPECT_THROW(ResponseParser::parseChunkSize(StringRef("\r\n", 2)),
+               ParseError);
+}
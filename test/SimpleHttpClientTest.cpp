@@ -1,6 +1,15 @@
+#include "AsyncHttpClient.hpp"
+#include "ConnectionPool.hpp"
 #include "SimpleHttpClient.hpp"
+#include "Socket.hpp"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
+
 using namespace DockerClientpp::Http;
 
 class IOTest : public ::testing::Test {
@@ -45,3 +54,586 @@ TEST_F(IOTest, TcpSocketTest) {
 TEST_F(IOTest, UnixSocketTest) {
   test(unix_client);
 }
+
+TEST_F(IOTest, KeepAliveTest) {
+  test(unix_client);
+  ConnectionStats stats = unix_client.getConnectionStats();
+  EXPECT_EQ(100u, stats.fresh + stats.reused);
+  EXPECT_GT(stats.reused, stats.fresh);
+}
+
+TEST_F(IOTest, StreamTest) {
+  auto res = unix_client.Get(uri, header, query_param);
+  string streamed;
+  auto stream_res = unix_client.GetStream(
+      uri, header, query_param, [&streamed](const char *data, size_t size) {
+        streamed.append(data, size);
+        return true;
+      });
+  EXPECT_EQ(200, stream_res->status_code);
+  EXPECT_TRUE(stream_res->body.empty());
+  EXPECT_EQ(res->body, streamed);
+}
+
+TEST_F(IOTest, PipelineTest) {
+  auto res = unix_client.Get(uri, header, query_param);
+  std::vector<Request> requests(100, {"GET", uri, header, query_param, ""});
+  auto responses = unix_client.Pipeline(requests);
+  ASSERT_EQ(requests.size(), responses.size());
+  for (auto &response : responses) {
+    EXPECT_EQ(200, response->status_code);
+    EXPECT_EQ(res->body, response->body);
+  }
+  EXPECT_LT(unix_client.getConnectionStats().fresh, 3u);
+}
+
+namespace {
+class PieceReader : public BodyReader {
+ public:
+  PieceReader(const string &data, size_t piece, bool known_size)
+      : data(data), piece(piece), known_size(known_size), pos(0) {}
+  size_t read(char *buffer, size_t size) override {
+    size_t n = std::min({size, piece, data.size() - pos});
+    std::copy(data.data() + pos, data.data() + pos + n, buffer);
+    pos += n;
+    return n;
+  }
+  size_t sizeHint() const override {
+    return known_size ? data.size() - pos : 0;
+  }
+
+ private:
+  const string &data;
+  size_t piece;
+  bool known_size;
+  size_t pos;
+};
+}  // namespace
+
+TEST(BodyReaderTest, ReadAllTest) {
+  string data(1000 * 1000 + 7, 'x');
+  for (size_t i = 0; i < data.size(); i += 101) data[i] = 'a' + i % 26;
+  PieceReader sized(data, 70000, true);
+  string sized_body = sized.readAll();
+  EXPECT_EQ(data, sized_body);
+  //  Known size is allocated once, not doubled at the end
+  EXPECT_LT(sized_body.capacity(), data.size() * 2);
+  PieceReader unsized(data, 3000, false);
+  EXPECT_EQ(data, unsized.readAll());
+  const string nothing;
+  PieceReader empty(nothing, 10, true);
+  EXPECT_EQ("", empty.readAll());
+  //  Empty and small bodies of known size get no read-ahead room
+  PieceReader unsized_empty(nothing, 10, false);
+  EXPECT_GT(64u, unsized_empty.readAll().capacity());
+  const string small(100, 's');
+  PieceReader small_sized(small, 30, true);
+  string small_body = small_sized.readAll();
+  EXPECT_EQ(small, small_body);
+  EXPECT_GT(256u, small_body.capacity());
+}
+
+namespace {
+/**
+ * @brief Unix socket that takes connections into its backlog and never
+ *        answers, like a wedged daemon
+ */
+class SilentListener {
+ public:
+  explicit SilentListener(const string &path) : path(path) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_storage addr;
+    socklen_t length =
+        DockerClientpp::Socket::makeAddress(DockerClientpp::SOCK_UNIX, path,
+                                            addr);
+    unlink(path.c_str());
+    bind(fd, reinterpret_cast<sockaddr *>(&addr), length);
+    listen(fd, 16);
+  }
+  ~SilentListener() {
+    close(fd);
+    unlink(path.c_str());
+  }
+
+ private:
+  string path;
+  int fd;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+}  // namespace
+
+TEST(TimeoutTest, FirstByteTest) {
+  SilentListener listener("silent.sock");
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "silent.sock");
+  Timeouts timeouts;
+  timeouts.first_byte = std::chrono::milliseconds(100);
+  client.setTimeouts(timeouts);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_THROW(client.Get("/_ping", {}, {}), DockerClientpp::TimeoutError);
+  EXPECT_LE(100, elapsedMs(start));
+  EXPECT_GT(2000, elapsedMs(start));
+  //  The timed out connection is not reused
+  EXPECT_THROW(client.Get("/_ping", {}, {}), DockerClientpp::TimeoutError);
+  EXPECT_EQ(2u, client.getConnectionStats().fresh);
+}
+
+TEST(TimeoutTest, DeadlineScopeTest) {
+  SilentListener listener("silent.sock");
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "silent.sock");
+  Timeouts timeouts;
+  timeouts.first_byte = std::chrono::seconds(10);
+  client.setTimeouts(timeouts);
+  EXPECT_EQ(DeadlineScope::Clock::time_point::max(), DeadlineScope::current());
+  {
+    DeadlineScope budget(std::chrono::milliseconds(300));
+    //  Time spent before the request comes out of the same budget
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(client.Get("/_ping", {}, {}), DockerClientpp::TimeoutError);
+    EXPECT_GT(1000, elapsedMs(start));
+    {
+      //  Inner scopes cannot extend the deadline
+      DeadlineScope longer(std::chrono::seconds(60));
+      start = std::chrono::steady_clock::now();
+      EXPECT_THROW(client.Get("/_ping", {}, {}),
+                   DockerClientpp::TimeoutError);
+      EXPECT_GT(1000, elapsedMs(start));
+    }
+  }
+  EXPECT_EQ(DeadlineScope::Clock::time_point::max(), DeadlineScope::current());
+}
+
+namespace {
+const string OK_RESPONSE = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+/**
+ * @brief Accepted connection of a ScriptedServer
+ */
+class ScriptedConnection {
+ public:
+  ScriptedConnection(int fd, std::atomic<size_t> &requests)
+      : fd(fd), requests(requests) {}
+
+  /**
+   * @brief Read the next request head, false once the client closed
+   */
+  bool readRequest() {
+    size_t end;
+    while ((end = buffer.find("\r\n\r\n")) == string::npos) {
+      char data[4096];
+      ssize_t n = read(fd, data, sizeof(data));
+      if (n <= 0) return false;
+      buffer.append(data, n);
+    }
+    buffer.erase(0, end + 4);
+    requests++;
+    return true;
+  }
+
+  void send(const string &data) {
+    ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+  }
+
+  /**
+   * @brief Read size bytes a few KiB at a time with pauses, so a writer
+   *        keeps finding the socket buffer full
+   */
+  string receiveSlowly(size_t size) {
+    string received;
+    while (received.size() < size) {
+      char data[4096];
+      size_t wanted = std::min(sizeof(data), size - received.size());
+      ssize_t n = read(fd, data, wanted);
+      if (n <= 0) break;
+      received.append(data, n);
+      std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    return received;
+  }
+
+  /**
+   * @brief Send data in uneven pieces with a pause after each, so the
+   *        client sees it arrive in short reads
+   */
+  void trickle(const string &data) {
+    const size_t pieces[] = {1, 7, 300, 5000, 2, 17000, 64};
+    size_t pos = 0;
+    for (size_t i = 0; pos < data.size(); i++) {
+      size_t n = std::min(pieces[i % 7], data.size() - pos);
+      send(data.substr(pos, n));
+      pos += n;
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+  }
+
+ private:
+  int fd;
+  std::atomic<size_t> &requests;
+  string buffer;
+};
+
+/**
+ * @brief Unix socket server running one script per accepted connection
+ *
+ * The connection is closed when its script returns
+ */
+class ScriptedServer {
+ public:
+  typedef std::function<void(ScriptedConnection &connection)> Script;
+
+  ScriptedServer(const string &path, const std::vector<Script> &scripts,
+                 int backlog = 16)
+      : path(path), requests(0) {
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_storage addr;
+    socklen_t length =
+        DockerClientpp::Socket::makeAddress(DockerClientpp::SOCK_UNIX, path,
+                                            addr);
+    unlink(path.c_str());
+    bind(fd, reinterpret_cast<sockaddr *>(&addr), length);
+    listen(fd, backlog);
+    server = std::thread([this, scripts] {
+      for (const Script &script : scripts) {
+        int connection_fd = accept(fd, nullptr, nullptr);
+        if (connection_fd < 0) return;
+        ScriptedConnection connection(connection_fd, requests);
+        script(connection);
+        close(connection_fd);
+      }
+    });
+  }
+
+  ~ScriptedServer() {
+    stop();
+    close(fd);
+    unlink(path.c_str());
+  }
+
+  /**
+   * @brief Stop accepting and wait for the running script
+   * @return number of requests the server read
+   */
+  size_t stop() {
+    if (server.joinable()) {
+      shutdown(fd, SHUT_RDWR);
+      server.join();
+    }
+    return requests;
+  }
+
+ private:
+  string path;
+  int fd;
+  std::atomic<size_t> requests;
+  std::thread server;
+};
+}  // namespace
+
+TEST(RetryTest, KeptAliveRetryTest) {
+  //  Each connection answers one request, then closes on the next one
+  //  without answering it
+  auto answer_once = [](ScriptedConnection &connection) {
+    if (!connection.readRequest()) return;
+    connection.send(OK_RESPONSE);
+    connection.readRequest();
+  };
+  ScriptedServer server("scripted.sock", {answer_once, answer_once,
+                                          answer_once});
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  Header header{{"Content-Length", "0"}};
+  EXPECT_EQ("ok", client.Get("/1", header, {})->body);
+  //  Sent again on a fresh connection
+  EXPECT_EQ("ok", client.Get("/2", header, {})->body);
+  //  The daemon may have run it, so it is not
+  EXPECT_THROW(client.Post("/3", header, {}, ""), DockerClientpp::SocketError);
+  EXPECT_EQ(4u, server.stop());
+  EXPECT_EQ(2u, client.getConnectionStats().fresh);
+}
+
+TEST(RetryTest, PipelineRetryTest) {
+  const string closing_response =
+      "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok";
+  //  Reads the whole window, answers the first request and closes
+  auto answer_first = [&closing_response](size_t window) {
+    return [&closing_response, window](ScriptedConnection &connection) {
+      for (size_t i = 0; i < window; i++) {
+        if (!connection.readRequest()) return;
+      }
+      connection.send(closing_response);
+    };
+  };
+  auto answer_all = [](ScriptedConnection &connection) {
+    while (connection.readRequest()) connection.send(OK_RESPONSE);
+  };
+  Request get{"GET", "/get", {{"Content-Length", "0"}}, {}, ""};
+  Request post{"POST", "/post", {{"Content-Length", "0"}}, {}, ""};
+
+  {
+    ScriptedServer server("scripted.sock", {answer_first(2), answer_all});
+    SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+    auto responses = client.Pipeline({get, get});
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ("ok", responses[1]->body);
+    client.setKeepAlive(false);
+    EXPECT_EQ(3u, server.stop());
+  }
+  {
+    ScriptedServer server("scripted.sock", {answer_first(3), answer_all});
+    SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+    EXPECT_THROW(client.Pipeline({get, post, get}),
+                 DockerClientpp::SocketError);
+    //  Nothing was sent again
+    EXPECT_EQ(3u, server.stop());
+  }
+}
+
+TEST(RetryTest, PipelineDropTest) {
+  //  Answers the first window of 64 and two requests of the next one, then
+  //  closes the connection without a word
+  auto drop_midway = [](ScriptedConnection &connection) {
+    for (size_t i = 0; i < 64 + 6; i++) {
+      if (!connection.readRequest()) return;
+      if (i < 64 + 2) connection.send(OK_RESPONSE);
+    }
+  };
+  auto answer_all = [](ScriptedConnection &connection) {
+    while (connection.readRequest()) connection.send(OK_RESPONSE);
+  };
+  ScriptedServer server("scripted.sock", {drop_midway, answer_all});
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  Request get{"GET", "/get", {{"Content-Length", "0"}}, {}, ""};
+  auto responses = client.Pipeline(std::vector<Request>(70, get));
+  ASSERT_EQ(70u, responses.size());
+  for (auto &response : responses) {
+    ASSERT_TRUE(response);
+    EXPECT_EQ("ok", response->body);
+  }
+  client.setKeepAlive(false);
+  //  Only the four unanswered requests were sent again
+  EXPECT_EQ(74u, server.stop());
+  EXPECT_EQ(2u, client.getConnectionStats().fresh);
+}
+
+TEST(RetryTest, AsyncRetryTest) {
+  auto answer_once = [](ScriptedConnection &connection) {
+    if (!connection.readRequest()) return;
+    connection.send(OK_RESPONSE);
+    connection.readRequest();
+  };
+  ScriptedServer server("scripted.sock", {answer_once, answer_once,
+                                          answer_once});
+  AsyncHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock", 1);
+  auto send = [&client](const string &method) {
+    std::promise<std::shared_ptr<Response>> done;
+    Request request{method, "/" + method, {{"Content-Length", "0"}}, {}, ""};
+    client.send(request, [&done](std::shared_ptr<Response> response,
+                                 std::exception_ptr error) {
+      if (error) {
+        done.set_exception(error);
+      } else {
+        done.set_value(response);
+      }
+    });
+    return done.get_future().get();
+  };
+  EXPECT_EQ("ok", send("GET")->body);
+  EXPECT_EQ("ok", send("GET")->body);
+  EXPECT_THROW(send("POST"), DockerClientpp::SocketError);
+  EXPECT_EQ(4u, server.stop());
+}
+
+TEST(RetryTest, AsyncBacklogTest) {
+  const string closing_response =
+      "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok";
+  //  Slow to answer, so connections pile up in the backlog meanwhile
+  auto answer_slowly = [&closing_response](ScriptedConnection &connection) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (connection.readRequest()) connection.send(closing_response);
+  };
+  //  Connects beyond the single backlog slot fail with EAGAIN
+  std::vector<ScriptedServer::Script> scripts(4, answer_slowly);
+  ScriptedServer server("scripted.sock", scripts, 0);
+  AsyncHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock", 4);
+  std::vector<std::promise<string>> done(4);
+  for (auto &promise : done) {
+    Request request{"GET", "/get", {{"Content-Length", "0"}}, {}, ""};
+    client.send(request, [&promise](std::shared_ptr<Response> response,
+                                    std::exception_ptr error) {
+      if (error) {
+        promise.set_exception(error);
+      } else {
+        promise.set_value(response->body);
+      }
+    });
+  }
+  for (auto &promise : done) {
+    EXPECT_EQ("ok", promise.get_future().get());
+  }
+  EXPECT_EQ(4u, server.stop());
+}
+
+TEST(ShutdownTest, ShutdownTest) {
+  //  Never answers, holds the connection until the client closes it
+  auto silent = [](ScriptedConnection &connection) {
+    while (connection.readRequest()) {
+    }
+  };
+  ScriptedServer server("scripted.sock", {silent, silent});
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  std::thread stopper([&client] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    client.shutdown();
+  });
+  EXPECT_THROW(client.Get("/events", {}, {}), DockerClientpp::SocketError);
+  stopper.join();
+  //  A shut down client does not connect again
+  EXPECT_THROW(client.Get("/events", {}, {}), DockerClientpp::SocketError);
+  EXPECT_EQ(1u, server.stop());
+}
+
+TEST(PoolExpiryTest, IdleTimeoutTest) {
+  auto answer_all = [](ScriptedConnection &connection) {
+    while (connection.readRequest()) connection.send(OK_RESPONSE);
+  };
+  ScriptedServer server("scripted.sock", {answer_all, answer_all});
+  PoolOptions options;
+  options.idle_timeout = std::chrono::milliseconds(50);
+  ConnectionPool pool(DockerClientpp::SOCK_UNIX, "scripted.sock", options);
+  Header header{{"Content-Length", "0"}};
+  {
+    auto connection = pool.acquire();
+    EXPECT_EQ("ok", connection->Get("/1", header, {})->body);
+  }
+  {
+    auto connection = pool.acquire();
+    EXPECT_EQ("ok", connection->Get("/2", header, {})->body);
+    EXPECT_EQ(1u, connection->getConnectionStats().reused);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  {
+    //  The connection kept for min_size expired, it is not handed out
+    auto connection = pool.acquire();
+    EXPECT_EQ("ok", connection->Get("/3", header, {})->body);
+    ConnectionStats stats = connection->getConnectionStats();
+    EXPECT_EQ(1u, stats.fresh);
+    EXPECT_EQ(0u, stats.reused);
+  }
+  EXPECT_EQ(1u, pool.size());
+}
+
+TEST(BufferedReadTest, ReadLineTest) {
+  const string long_line(40000, 'l');
+  ScriptedServer server(
+      "scripted.sock", {[&long_line](ScriptedConnection &connection) {
+        connection.trickle("first\r\nsecond\r\n" + long_line + "\r\n");
+        //  Split between CR and LF
+        connection.send("third\r");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        connection.send("\nlast\r\n");
+        connection.readRequest();
+      }});
+  DockerClientpp::Socket socket(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  socket.connect();
+  string line;
+  EXPECT_EQ("first", socket.readLine(line));
+  line.clear();
+  EXPECT_EQ("second", socket.readLine(line));
+  line.clear();
+  EXPECT_EQ(long_line, socket.readLine(line));
+  char buffer[64];
+  EXPECT_EQ(5u, socket.readLine(buffer));
+  EXPECT_STREQ("third", buffer);
+  EXPECT_EQ(4u, socket.readLine(buffer));
+  EXPECT_STREQ("last", buffer);
+  socket.close();
+}
+
+TEST(BufferedReadTest, MixedReadTest) {
+  //  More than the 16 KiB read buffer, part of it is read ahead with the
+  //  line and the rest goes straight to the destination
+  string data(50000, 'd');
+  for (size_t i = 0; i < data.size(); i += 89) data[i] = 'a' + i % 26;
+  ScriptedServer server("scripted.sock",
+                        {[&data](ScriptedConnection &connection) {
+                          connection.send("size 50000\r\n" + data + "tail");
+                          connection.readRequest();
+                        }});
+  DockerClientpp::Socket socket(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  socket.connect();
+  string line;
+  EXPECT_EQ("size 50000", socket.readLine(line));
+  string received(data.size(), '\0');
+  socket.read(&received[0], received.size());
+  EXPECT_EQ(data, received);
+  EXPECT_EQ("tail", socket.read(4));
+  socket.close();
+}
+
+TEST(BufferedReadTest, TrickledResponseTest) {
+  //  Head longer than the read buffer, so it has to grow
+  const string long_value(40000, 'v');
+  string body(100 * 1000, 'b');
+  for (size_t i = 0; i < body.size(); i += 101) body[i] = 'a' + i % 26;
+  string chunked;
+  for (size_t pos = 0; pos < body.size(); pos += 30000) {
+    size_t n = std::min<size_t>(30000, body.size() - pos);
+    char size_line[16];
+    snprintf(size_line, sizeof(size_line), "%zx\r\n", n);
+    chunked += size_line + body.substr(pos, n) + "\r\n";
+  }
+  chunked += "0\r\n\r\n";
+  ScriptedServer server(
+      "scripted.sock", {[&](ScriptedConnection &connection) {
+        if (!connection.readRequest()) return;
+        connection.trickle("HTTP/1.1 200 OK\r\nX-Long: " + long_value +
+                           "\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\n\r\n" + body);
+        if (!connection.readRequest()) return;
+        connection.trickle(
+            "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" +
+            chunked);
+        connection.readRequest();
+      }});
+  SimpleHttpClient client(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  Header header{{"Content-Length", "0"}};
+  auto sized = client.Get("/sized", header, {});
+  ASSERT_NE(sized->header.end(), sized->header.find("X-Long"));
+  EXPECT_EQ(long_value, sized->header.find("X-Long")->second);
+  EXPECT_EQ(body, sized->body);
+  auto chunked_response = client.Get("/chunked", header, {});
+  EXPECT_EQ(body, chunked_response->body);
+  EXPECT_EQ(1u, client.getConnectionStats().reused);
+  client.setKeepAlive(false);
+}
+
+TEST(GatheredWriteTest, PartialSendTest) {
+  //  Far more than the socket buffer takes, with odd sizes so the partial
+  //  sends end in the middle of a buffer
+  std::vector<string> pieces{string(100003, 'a'), string(13, 'b'),
+                             string(250007, 'c'), string(400009, 'd')};
+  string expected;
+  for (auto &piece : pieces) {
+    for (size_t i = 0; i < piece.size(); i += 7) piece[i] = '0' + i % 10;
+    expected += piece;
+  }
+  string received;
+  ScriptedServer server("scripted.sock",
+                        {[&](ScriptedConnection &connection) {
+                          received = connection.receiveSlowly(expected.size());
+                        }});
+  DockerClientpp::Socket socket(DockerClientpp::SOCK_UNIX, "scripted.sock");
+  socket.connect();
+  std::vector<iovec> iov;
+  for (auto &piece : pieces) iov.push_back({&piece[0], piece.size()});
+  socket.write(iov.data(), iov.size());
+  //  The server stops reading at EOF if bytes went missing
+  socket.close();
+  server.stop();
+  EXPECT_EQ(expected.size(), received.size());
+  EXPECT_TRUE(expected == received);
+}
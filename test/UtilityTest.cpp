@@ -0,0 +1,83 @@
+#include "Exceptions.hpp"
+#include "Utility.hpp"
+#include "gtest/gtest.h"
+
+using namespace DockerClientpp;
+using Utility::JsonScanner;
+
+TEST(JsonScannerTest, ReadMembersTest) {
+  const string text =
+      R"({"Id": "abc", "Skip": {"a": [1, {"b": "}"}], "c": null},)"
+      R"( "Count": -12, "Size": 18446744073709551615, "Ratio": 0.5e1,)"
+      R"( "On": true, "Off": false, "None": null, "List": [1, 2, 3]})";
+  JsonScanner scanner(text.data(), text.data() + text.size());
+  string key;
+  vector<string> keys;
+  int64_t sum = 0;
+  scanner.beginObject();
+  while (scanner.nextMember(key)) {
+    keys.push_back(key);
+    if (key == "Id") {
+      EXPECT_EQ("abc", scanner.readString());
+    } else if (key == "Count") {
+      EXPECT_EQ(-12, scanner.readInteger());
+    } else if (key == "Size") {
+      EXPECT_EQ(UINT64_MAX, scanner.readUnsigned());
+    } else if (key == "Ratio") {
+      EXPECT_DOUBLE_EQ(5.0, scanner.readDouble());
+    } else if (key == "On") {
+      EXPECT_TRUE(scanner.readBool());
+    } else if (key == "Off") {
+      EXPECT_FALSE(scanner.readBool());
+    } else if (key == "None") {
+      EXPECT_EQ('N', scanner.peek());
+      EXPECT_TRUE(scanner.readNull());
+    } else if (key == "List") {
+      scanner.beginArray();
+      while (scanner.nextElement()) sum += scanner.readInteger();
+    } else {
+      scanner.skipValue();
+    }
+  }
+  EXPECT_EQ(vector<string>({"Id", "Skip", "Count", "Size", "Ratio", "On",
+                            "Off", "None", "List"}),
+            keys);
+  EXPECT_EQ(6, sum);
+  EXPECT_EQ(0, scanner.peek());
+}
+
+TEST(JsonScannerTest, EscapeTest) {
+  const string text = R"(["a\"b\\\/\n\t", "é中", "😀"])";
+  JsonScanner scanner(text.data(), text.data() + text.size());
+  scanner.beginArray();
+  ASSERT_TRUE(scanner.nextElement());
+  EXPECT_EQ("a\"b\\/\n\t", scanner.readString());
+  ASSERT_TRUE(scanner.nextElement());
+  EXPECT_EQ("\xc3\xa9\xe4\xb8\xad", scanner.readString());
+  ASSERT_TRUE(scanner.nextElement());
+  EXPECT_EQ("\xf0\x9f\x98\x80", scanner.readString());
+  EXPECT_FALSE(scanner.nextElement());
+}
+
+TEST(JsonScannerTest, MalformedTest) {
+  const string truncated = R"({"Id": "abc)";
+  JsonScanner first(truncated.data(), truncated.data() + truncated.size());
+  first.beginObject();
+  string key;
+  ASSERT_TRUE(first.nextMember(key));
+  EXPECT_THROW(first.readString(), ParseError);
+
+  const string mistyped = R"({"Count": "12"})";
+  JsonScanner second(mistyped.data(), mistyped.data() + mistyped.size());
+  second.beginObject();
+  ASSERT_TRUE(second.nextMember(key));
+  EXPECT_THROW(second.readInteger(), ParseError);
+
+  const string missing_comma = R"([1 2])";
+  JsonScanner third(missing_comma.data(),
+                    missing_comma.data() + missing_comma.size());
+  third.beginArray();
+  ASSERT_TRUE(third.nextElement());
+  third.skipValue();
+  EXPECT_THROW(third.nextElement(), ParseError);
+}
@@ -0,0 +1,69 @@
+#include <atomic>
+#include <coroutine>
+#include <future>
+
+#include "CoroDockerClient.hpp"
+#include "DockerClient.hpp"
+#include "gtest/gtest.h"
+
+using namespace DockerClientpp;
+
+namespace {
+/**
+ * @brief Eagerly started coroutine that reports completion to a promise
+ */
+struct Flow {
+  struct promise_type {
+    Flow get_return_object() {
+      return {};
+    }
+    std::suspend_never initial_suspend() noexcept {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept {
+      return {};
+    }
+    void return_void() {}
+    void unhandled_exception() {
+      std::terminate();
+    }
+  };
+};
+
+Flow inspectTwice(CoroDockerClient &client, std::promise<string> &done) {
+  string first = co_await client.getLongId("test");
+  string second = co_await client.getLongId(first);
+  done.set_value(second);
+}
+
+Flow inspectMissing(CoroDockerClient &client, std::promise<int> &done) {
+  try {
+    co_await client.inspectContainer("no-such-container");
+    done.set_value(0);
+  } catch (const DockerOperationError &e) {
+    done.set_value(e.status_code);
+  }
+}
+}  // namespace
+
+TEST(CoroTest, ConcurrentFlowTest) {
+  DockerClient dc;
+  const string long_id = dc.getLongId("test");
+  CoroDockerClient client(DockerClientpp::SOCK_UNIX, "/var/run/docker.sock",
+                          4);
+  std::vector<std::promise<string>> done(100);
+  for (auto &promise : done) {
+    inspectTwice(client, promise);
+  }
+  for (auto &promise : done) {
+    EXPECT_EQ(long_id, promise.get_future().get());
+  }
+  EXPECT_LE(client.getConnectionStats().fresh, 4u);
+}
+
+TEST(CoroTest, ErrorTest) {
+  CoroDockerClient client;
+  std::promise<int> done;
+  inspectMissing(client, done);
+  EXPECT_EQ(404, done.get_future().get());
+}